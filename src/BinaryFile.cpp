@@ -0,0 +1,38 @@
+#include "BinaryFile.h"
+
+std::vector<byte> readBinaryFile(const char *filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::string("Failed to open ") + filename);
+    }
+
+    file.unsetf(std::ios::skipws);
+
+    std::streampos bufSize;
+
+    file.seekg(0, std::ios::end);
+    bufSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    // reserve capacity
+    std::vector<byte> vec(bufSize);
+
+    file.read(reinterpret_cast<char *>(vec.data()), vec.size());
+
+    return vec;
+}
+
+void writeBinaryFile(const char *filename, const std::vector<byte> &data)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::string("Failed to open ") + filename);
+    }
+
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
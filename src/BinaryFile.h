@@ -0,0 +1,35 @@
+#pragma once
+
+#include "types.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::vector<byte> readBinaryFile(const char *filename);
+
+void writeBinaryFile(const char *filename, const std::vector<byte> &data);
+
+template<class T>
+void writeLE(std::ostream &stream, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        stream.put(static_cast<char>((value >> (8 * i)) & 0xffu));
+    }
+}
+
+//Reads a T at pos and moves pos past it
+template<class T>
+T readLE(const std::vector<byte> &data, size_t &pos)
+{
+    if (pos + sizeof(T) > data.size()) throw std::runtime_error("Unexpected end of file");
+
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        value |= static_cast<T>(data[pos++]) << (8 * i);
+    }
+    return value;
+}
@@ -1,5 +1,23 @@
 #include "CHIP8.h"
 
+//What the rewind buffer records every frame. It's compared byte by byte, so it's always cleared first to keep the
+//padding from showing up as changes.
+struct FrameState
+{
+    std::array<byte, MEMORY_SIZE> memory;
+    std::array<bool, NUM_PIXELS> framebuffer;
+    std::array<bool, KEYPAD_SIZE> keys;
+    reg registers[16];
+    word indexRegister;
+    word pc;
+    word sp;
+    byte soundTimer;
+    byte delayTimer;
+    uint32_t rngState;
+    uint64_t cycles;
+    unsigned int clockCounter;
+};
+
 static const std::vector<byte> FONT = {
         0xf0, 0x90, 0x90, 0x90, 0xf0, //0
         0x20, 0x60, 0x20, 0x20, 0x70, //1
@@ -19,15 +37,38 @@ static const std::vector<byte> FONT = {
         0xf0, 0x80, 0xf0, 0x80, 0x80  //F
 };
 
-CHIP8::CHIP8(const std::vector<byte> &ROM) : _cpu{}, _memory{}, _io{"CHIP-8"}, _jit(_cpu, _memory, _io)
+//A frame this long misses a refresh of a 60Hz display, with the next frame already on time
+static constexpr auto MISSED_FRAME_DURATION = 1.5 / TIMER_HZ * 1s;
+
+CHIP8::CHIP8(const std::vector<byte> &ROM, IOBackend &backend, const CHIP8Options &options)
+        : _cpu(options.seed ? *options.seed : std::random_device{}()), _memory{}, _io{backend},
+          _coverage(options.coverage != CoverageMode::Disabled ? std::make_unique<Coverage>(options.coverage)
+                                                               : nullptr),
+          _jit(_cpu, _memory, _io, options.jit, options.compilePool, _coverage.get()),
+          _trace(options.traceEntries), _skipIdle(options.skipIdle)
 {
-    std::copy(FONT.cbegin() + FONT_START, FONT.cend(), _memory.buf.begin());
+    if (const char *traceDir = std::getenv("CHIP8_TRACE_DIR")) _traceDir = traceDir;
+    if (options.verifyJIT) _verifier = std::make_unique<JITVerifier>();
+    _jit.setInstructionLimit(options.compiledInstructionLimit);
 
-    //The stack shall reside after the font. We have 512 bytes of space, and only 80 bytes are consumed by
-    //the font, so this should be okay.
-    assert((ROM_START - FONT.size()) > 64);     //Sanity check just in case
-    _cpu.sp = FONT_START + FONT.size();
-    _cpu.pc = ROM_START;
+    loadROM(_memory, ROM);
+    resetCpu(_cpu);
+
+    if (options.rewindBytes != 0)
+    {
+        _rewind = std::make_unique<RewindBuffer>(sizeof(FrameState), options.rewindBytes);
+        _recordFrame();
+    }
+
+    if (options.aot)
+    {
+        _jit.precompile(findSubroutines(_memory, ROM_START));
+    }
+}
+
+void CHIP8::loadROM(Memory &memory, const std::vector<byte> &ROM)
+{
+    std::copy(FONT.cbegin() + FONT_START, FONT.cend(), memory.buf.begin());
 
     //Copy the ROM over to the memory
     if (ROM.size() > (MEMORY_SIZE - ROM_START))
@@ -35,63 +76,524 @@ CHIP8::CHIP8(const std::vector<byte> &ROM) : _cpu{}, _memory{}, _io{"CHIP-8"}, _
         throw std::runtime_error("The ROM is too big. The max size for roms is 0xE00 bytes.");
     }
 
-    std::copy(ROM.cbegin(), ROM.cend(), _memory.buf.begin() + ROM_START);
+    std::copy(ROM.cbegin(), ROM.cend(), memory.buf.begin() + ROM_START);
+}
+
+void CHIP8::resetCpu(Cpu &cpu)
+{
+    //The stack shall reside after the font. We have 512 bytes of space, and only 80 bytes are consumed by
+    //the font, so this should be okay.
+    assert((ROM_START - FONT.size()) > 64);     //Sanity check just in case
+    assert(STACK_START == FONT_START + FONT.size());
+    cpu.sp = STACK_START;
+    cpu.pc = ROM_START;
 }
 
 void CHIP8::printSingleInstruction(word addr) const
 {
-    auto insn = parseInstruction(_memory.getOpcode(addr));
-    std::cout << std::hex << "0x" << addr << ": " << *insn << std::endl;
+    const Instruction &insn = parseInstruction(_memory.getOpcode(addr));
+    std::cout << std::hex << "0x" << addr << ": " << insn << std::endl;
+}
+
+void CHIP8::step()
+{
+    try
+    {
+        _step();
+    } catch (const std::exception &e)
+    {
+        if (!_traceDir.empty()) _writeTrace(e.what());
+        throw;
+    }
+}
+
+void CHIP8::_step()
+{
+    if (_cpu.pc & 1u) throw std::runtime_error("Odd address executed");
+
+    opcode opcode = _memory.getOpcode(_cpu.pc);
+    _trace.record(_cycles, _cpu.pc, opcode, _cpu.indexRegister, _cpu.sp);
+    const DecodedInstruction &decoded = decode(opcode);
+    const Instruction &insn = parseInstruction(opcode);
+
+    JITFunction jitFunctionPtr = nullptr;
+
+    if (decoded.op == Op::Call)
+    {
+        jitFunctionPtr = _jit.traceCall(decoded.nnn);
+    }
+
+    //Execute insn normally. Even if there's a JIT block, the CALL insn still needs to be executed.
+    //printSingleInstruction(_cpu.pc);
+    word pc = _cpu.pc;
+    _cpu.pc += sizeof(opcode);
+    insn.execute(_cpu, _memory, _io);
+
+    if (_coverage)
+    {
+        _coverage->hit(pc);
+        //The pc of a skip only moves on by an instruction if it didn't skip
+        if (decoded.isSkip() && _cpu.pc == pc + sizeof(opcode)) _coverage->fallThrough(pc);
+    }
+
+    if (jitFunctionPtr != nullptr)
+    {
+        if (_verifier) _verifier->before(_cpu, _memory, _io);
+        uint64_t instructions = _jit.getInstructions();
+
+        auto start = _timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        _inSection = true;
+        jitFunctionPtr(_jit.getContext());
+        _inSection = false;
+
+        if (_timed) _runLoopStats->jit.record(std::chrono::steady_clock::now() - start);
+
+        if (_verifier) _verifier->after(_jit.getInstructions() - instructions, _cpu, _memory, _io);
+    }
+
+    _io.pollEvents();
+
+    if (_cpu.soundTimer) _io.beep();
+
+    _cycles++;
+    _instructions++;
+
+    if (++_clockCounter == CLOCKS_PER_TIMER)
+    {
+        _tickTimers();
+        _clockCounter = 0;
+
+        if (_rewind) _recordFrame();
+    }
+}
+
+void CHIP8::_tickTimers()
+{
+    //The timers are volatile, which rules out decrementing them in place
+    if (_cpu.delayTimer) _cpu.delayTimer = _cpu.delayTimer - 1;
+    if (_cpu.soundTimer) _cpu.soundTimer = _cpu.soundTimer - 1;
+}
+
+void CHIP8::_writeTrace(const std::string &message) const
+{
+    //Several instances may fail in one process, batch runs do
+    static std::atomic<unsigned int> traceCount = 0;
+    std::string path = _traceDir + "/chip8-trace-" + std::to_string(getpid()) + "-" + std::to_string(traceCount++) +
+                       ".bin";
+
+    //The error the machine stopped on matters more than this one
+    try
+    {
+        writeTrace(path.c_str(), _trace, _cpu, _cycles, message);
+        std::cerr << "Trace written to " << path << std::endl;
+    } catch (const std::exception &e)
+    {
+        std::cerr << "Failed to write the trace: " << e.what() << std::endl;
+    }
+}
+
+uint64_t CHIP8::runFor(uint64_t cycles)
+{
+    //Sections compiled for the breakpoints of a runUntil() would keep leaving at them
+    _jit.setBreakpoints({});
+
+    uint64_t executed = 0;
+
+    while (executed < cycles && !_io.getExitFlag())
+    {
+        uint64_t skipped = _skipIdleCycles(cycles - executed);
+        if (skipped != 0)
+        {
+            executed += skipped;
+            continue;
+        }
+
+        step();
+        executed++;
+    }
+
+    return executed;
 }
 
 void CHIP8::run()
 {
-    unsigned int clockCounter = 0;
+    _jit.setBreakpoints({});
+
+    if (!_runLoopStats) _runLoopStats = std::make_unique<RunLoopStats>();
+    _io.setTimings(&_runLoopStats->draw, &_runLoopStats->poll);
+    _timed = true;
+
+    auto frameStart = std::chrono::steady_clock::now();
+    uint64_t frame = getFrames();
 
     while (!_io.getExitFlag())
     {
-        if (_cpu.pc & 1u) throw std::runtime_error("Odd address executed");
+        auto cycleStart = std::chrono::steady_clock::now();
 
-        auto cycleStart = std::chrono::high_resolution_clock::now();
+        //Idling is skipped a timer tick at most at a time, to keep polling input at least that often
+        uint64_t cycles = _skipIdleCycles(CLOCKS_PER_TIMER - _clockCounter);
+        if (cycles == 0)
+        {
+            step();
+            cycles = 1;
+        }
 
-        auto insn = parseInstruction(_memory.getOpcode(_cpu.pc));
+        auto currentCycleDuration = std::chrono::steady_clock::now() - cycleStart;
+        _runLoopStats->cycle.record(currentCycleDuration / cycles);
 
-        JITFunction jitFunctionPtr = nullptr;
+        auto sleepDuration = std::chrono::duration_cast<std::chrono::microseconds>(
+                static_cast<double>(cycles) * CYCLE_DURATION - currentCycleDuration).count();
 
-        if (auto *callInsn = dynamic_cast<Instructions::Call *>(insn.get()))
+        if (sleepDuration > 0)
         {
-            jitFunctionPtr = _jit.traceCall(callInsn->target);
+            auto sleepStart = std::chrono::steady_clock::now();
+            usleep(sleepDuration);
+            _runLoopStats->sleepOvershoot.record(
+                    std::chrono::steady_clock::now() - sleepStart - std::chrono::microseconds(sleepDuration));
         }
 
-        //Execute insn normally. Even if there's a JIT block, the CALL insn still needs to be executed.
-        //printSingleInstruction(_cpu.pc);
-        _cpu.pc += sizeof(opcode);
-        insn->execute(_cpu, _memory, _io);
+        if (getFrames() != frame)
+        {
+            auto now = std::chrono::steady_clock::now();
+            _runLoopStats->frame.record(now - frameStart);
+            if (now - frameStart > MISSED_FRAME_DURATION) _runLoopStats->missedFrames++;
 
-        if (jitFunctionPtr != nullptr)
+            frameStart = now;
+            frame = getFrames();
+        }
+    }
+
+    _timed = false;
+    _io.setTimings(nullptr, nullptr);
+}
+
+StopReason CHIP8::runUntil(const RunConditions &conditions)
+{
+    bool hasBreakpoints = conditions.breakpoints.any();
+    _jit.setBreakpoints(conditions.breakpoints);
+
+    //Frames end on a tick, which is every CLOCKS_PER_TIMER cycles since the start, so both limits are a cycle count
+    uint64_t cycleLimit = conditions.cycles.value_or(UINT64_MAX);
+    uint64_t frameLimit = UINT64_MAX;
+    if (conditions.frames && *conditions.frames < UINT64_MAX / CLOCKS_PER_TIMER)
+    {
+        frameLimit = *conditions.frames * CLOCKS_PER_TIMER;
+    }
+
+    bool watchesFrames = conditions.framebufferHash.has_value() || !conditions.memoryValues.empty();
+    uint64_t hashedDraws = _io.getDrawCount();
+    uint64_t hash = conditions.framebufferHash ? hashFramebuffer(_io.getBitmap()) : 0;
+
+    while (true)
+    {
+        if (_io.getExitFlag()) return StopReason::Exit;
+        if (_cycles >= cycleLimit) return StopReason::Cycles;
+        if (_cycles >= frameLimit) return StopReason::Frames;
+
+        word pc = _cpu.pc;
+        if (hasBreakpoints && pc < MEMORY_SIZE && conditions.breakpoints[pc] && _breakpointCycle != _cycles)
         {
-            jitFunctionPtr();
+            _breakpointCycle = _cycles;
+            return StopReason::Breakpoint;
         }
 
-        _io.pollEvents();
+        //A breakpoint in an idle loop has to be hit on every iteration, and the frame conditions have to be checked
+        //on every frame boundary
+        uint64_t maxSkip = std::min(cycleLimit, frameLimit) - _cycles;
+        if (watchesFrames) maxSkip = std::min<uint64_t>(maxSkip, CLOCKS_PER_TIMER - _clockCounter);
+        for (word addr = pc; hasBreakpoints && addr < pc + DELAY_LOOP_INSNS * sizeof(opcode) && addr < MEMORY_SIZE; ++addr)
+        {
+            if (conditions.breakpoints[addr]) maxSkip = 0;
+        }
 
-        if (_cpu.soundTimer) IO::beep();
+        if (maxSkip == 0 || _skipIdleCycles(maxSkip) == 0)
+        {
+            step();
+        }
 
-        if (++clockCounter == CLOCKS_PER_TIMER)
+        if (watchesFrames && _clockCounter == 0)
         {
-            if (_cpu.delayTimer) _cpu.delayTimer--;
-            if (_cpu.soundTimer) _cpu.soundTimer--;
-            clockCounter = 0;
+            auto reason = _checkFrame(conditions, hashedDraws, hash);
+            if (reason) return *reason;
         }
+    }
+}
 
-        auto currentCycleDuration = std::chrono::high_resolution_clock::now() - cycleStart;
+std::optional<StopReason> CHIP8::_checkFrame(const RunConditions &conditions, uint64_t &hashedDraws, uint64_t &hash)
+{
+    for (const auto &[addr, value] : conditions.memoryValues)
+    {
+        if (_memory.buf[addr & MEMORY_MASK] == value) return StopReason::Memory;
+    }
 
-        auto sleepDuration = std::chrono::duration_cast<std::chrono::microseconds>(
-                CYCLE_DURATION - currentCycleDuration).count();
+    if (conditions.framebufferHash)
+    {
+        if (_io.getDrawCount() != hashedDraws)
+        {
+            hashedDraws = _io.getDrawCount();
+            hash = hashFramebuffer(_io.getBitmap());
+        }
 
-        if (sleepDuration > 0)
+        if (hash == *conditions.framebufferHash) return StopReason::Framebuffer;
+    }
+
+    return std::nullopt;
+}
+
+uint64_t CHIP8::_skipIdleCycles(uint64_t maxCycles)
+{
+    //Rewinding needs every frame to be recorded as it happens
+    if (!_skipIdle || _rewind || (_cpu.pc & 1u) || _cpu.pc + DELAY_LOOP_INSNS * sizeof(opcode) > MEMORY_SIZE) return 0;
+
+    word pc = _cpu.pc;
+    opcode first = _memory.getOpcode(pc);
+    const DecodedInstruction &insn = decode(first);
+
+    if (insn.op == Op::Ld_reg_K)
+    {
+        //ld Vx, K executes again every cycle until a key is down
+        if (std::find(_io.getKeys().cbegin(), _io.getKeys().cend(), true) != _io.getKeys().cend()) return 0;
+
+        uint64_t cycles = _io.getIdlePolls(maxCycles);
+        _io.skipPolls(cycles);
+        _advanceClock(cycles);
+        if (_coverage) _coverage->hit(pc, cycles);
+        return cycles;
+    }
+
+    if (_cpu.delayTimer == 0 ||
+        !isDelayLoop(pc, first, _memory.getOpcode(pc + sizeof(opcode)), _memory.getOpcode(pc + 2 * sizeof(opcode))))
+    {
+        return 0;
+    }
+
+    //Iteration i loads the timer on cycle DELAY_LOOP_INSNS * i from now, after (_clockCounter + that) / CLOCKS_PER_TIMER
+    //ticks. Every iteration that still loads a non-zero value comes back here with nothing changed but Vx.
+    uint64_t timer = _cpu.delayTimer;
+    uint64_t iterations = (timer * CLOCKS_PER_TIMER - _clockCounter - 1) / DELAY_LOOP_INSNS + 1;
+
+    iterations = std::min(iterations, maxCycles / DELAY_LOOP_INSNS);
+    iterations = std::min(iterations, _io.getIdlePolls(iterations * DELAY_LOOP_INSNS) / DELAY_LOOP_INSNS);
+    if (iterations == 0) return 0;
+
+    uint64_t lastLoad = (iterations - 1) * DELAY_LOOP_INSNS;
+    _cpu.getRegister(insn.regX()) = timer - (_clockCounter + lastLoad) / CLOCKS_PER_TIMER;
+
+    uint64_t cycles = iterations * DELAY_LOOP_INSNS;
+    _io.skipPolls(cycles);
+    _advanceClock(cycles);
+
+    //Every skipped iteration ran the whole loop, and the se fell through
+    if (_coverage)
+    {
+        for (word insnPC = pc; insnPC < pc + DELAY_LOOP_INSNS * sizeof(opcode); insnPC += sizeof(opcode))
         {
-            usleep(sleepDuration);
+            _coverage->hit(insnPC, iterations);
+        }
+        _coverage->fallThrough(pc + sizeof(opcode), iterations);
+    }
+
+    return cycles;
+}
+
+void CHIP8::_advanceClock(uint64_t cycles)
+{
+    _instructions += cycles;
+
+    while (cycles != 0)
+    {
+        //Nothing left to tick
+        if (_cpu.delayTimer == 0 && _cpu.soundTimer == 0)
+        {
+            _cycles += cycles;
+            _clockCounter = (_clockCounter + cycles) % CLOCKS_PER_TIMER;
+            return;
         }
+
+        uint64_t untilTick = std::min<uint64_t>(cycles, CLOCKS_PER_TIMER - _clockCounter);
+        if (_cpu.soundTimer)
+        {
+            for (uint64_t i = 0; i < untilTick; ++i) _io.beep();
+        }
+
+        _cycles += untilTick;
+        _clockCounter += untilTick;
+        cycles -= untilTick;
+
+        if (_clockCounter == CLOCKS_PER_TIMER)
+        {
+            _tickTimers();
+            _clockCounter = 0;
+        }
+    }
+}
+
+Snapshot CHIP8::snapshot()
+{
+    static_assert(sizeof(bool) == sizeof(byte));
+
+    const Snapshot *base = _lastSnapshot.has_value() ? &_lastSnapshot.value() : nullptr;
+
+    Snapshot snapshot{
+            _cpu,
+            ChunkedCopy<MEMORY_SIZE>(_memory.buf.data(), base ? &base->memory : nullptr),
+            ChunkedCopy<MEMORY_SIZE / 2>(_memory.dirtyMap.data(), base ? &base->dirtyMap : nullptr),
+            ChunkedCopy<NUM_PIXELS>(reinterpret_cast<const byte *>(_io.getBitmap().data()),
+                                    base ? &base->framebuffer : nullptr),
+            _io.getKeys(),
+            _cycles,
+            _clockCounter
+    };
+
+    _lastSnapshot = snapshot;
+    return snapshot;
+}
+
+void CHIP8::restore(const Snapshot &snapshot)
+{
+    constexpr size_t CHUNK_SIZE = ChunkedCopy<MEMORY_SIZE>::CHUNK_SIZE;
+
+    std::array<byte, MEMORY_SIZE / 2> dirtyMap = {};
+    snapshot.dirtyMap.copyTo(dirtyMap.data());
+    for (size_t i = 0; i < dirtyMap.size(); ++i)
+    {
+        _memory.dirtyMap[i] |= dirtyMap[i];
+    }
+
+    for (size_t chunk = 0; chunk < ChunkedCopy<MEMORY_SIZE>::NUM_CHUNKS; ++chunk)
+    {
+        _loadMemory(snapshot.memory.chunk(chunk), chunk * CHUNK_SIZE, CHUNK_SIZE);
+    }
+
+    _cpu = snapshot.cpu;
+    snapshot.framebuffer.copyTo(reinterpret_cast<byte *>(_io.getBitmap().data()));
+    _io.getKeys() = snapshot.keys;
+    _cycles = snapshot.cycles;
+    _clockCounter = snapshot.clockCounter;
+
+    _lastSnapshot = snapshot;
+
+    _io.draw();
+}
+
+size_t CHIP8::rewind(size_t frames)
+{
+    if (!_rewind) throw std::runtime_error("Rewinding is disabled");
+
+    FrameState state{};
+    size_t rewound = _rewind->rewind(frames, reinterpret_cast<byte *>(&state));
+
+    _loadMemory(state.memory.data(), 0, MEMORY_SIZE);
+
+    std::copy(std::begin(state.registers), std::end(state.registers), std::begin(_cpu.registers));
+    _cpu.indexRegister = state.indexRegister;
+    _cpu.pc = state.pc;
+    _cpu.sp = state.sp;
+    _cpu.soundTimer = state.soundTimer;
+    _cpu.delayTimer = state.delayTimer;
+    _cpu.rngState = state.rngState;
+
+    _io.getBitmap() = state.framebuffer;
+    _io.getKeys() = state.keys;
+    _cycles = state.cycles;
+    _clockCounter = state.clockCounter;
+
+    _io.draw();
+
+    return rewound;
+}
+
+void CHIP8::_loadMemory(const byte *src, size_t offset, size_t size)
+{
+    //Only bytes that actually change are marked dirty, so sections compiled from the same code keep running
+    byte *dst = _memory.buf.data() + offset;
+    if (std::memcmp(src, dst, size) == 0) return;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (src[i] != dst[i]) _memory.dirtyMap[(offset + i) >> DIRTY_MAP_SHR] = 1;
     }
-}
\ No newline at end of file
+    std::memcpy(dst, src, size);
+}
+
+void CHIP8::_recordFrame()
+{
+    FrameState state;
+    std::memset(&state, 0, sizeof(state));
+
+    state.memory = _memory.buf;
+    state.framebuffer = _io.getBitmap();
+    state.keys = _io.getKeys();
+    std::copy(std::begin(_cpu.registers), std::end(_cpu.registers), std::begin(state.registers));
+    state.indexRegister = _cpu.indexRegister;
+    state.pc = _cpu.pc;
+    state.sp = _cpu.sp;
+    state.soundTimer = _cpu.soundTimer;
+    state.delayTimer = _cpu.delayTimer;
+    state.rngState = _cpu.rngState;
+    state.cycles = _cycles;
+    state.clockCounter = _clockCounter;
+
+    _rewind->push(reinterpret_cast<const byte *>(&state));
+}
+
+uint64_t CHIP8::getCycles() const
+{
+    return _cycles;
+}
+
+uint64_t CHIP8::getFrames() const
+{
+    return _cycles / CLOCKS_PER_TIMER;
+}
+
+uint64_t CHIP8::getInstructions() const
+{
+    return _instructions + _jit.getInstructions();
+}
+
+const Coverage *CHIP8::getCoverage() const
+{
+    return _coverage.get();
+}
+
+const TraceRing &CHIP8::getTrace() const
+{
+    return _trace;
+}
+
+const JITVerifier *CHIP8::getJITVerifier() const
+{
+    return _verifier.get();
+}
+
+bool CHIP8::isInSection() const
+{
+    return _inSection;
+}
+
+JITStats CHIP8::getJITStats() const
+{
+    return _jit.getStats();
+}
+
+const RunLoopStats *CHIP8::getRunLoopStats() const
+{
+    return _runLoopStats.get();
+}
+
+const Cpu &CHIP8::getCpu() const
+{
+    return _cpu;
+}
+
+const Memory &CHIP8::getMemory() const
+{
+    return _memory;
+}
+
+IO &CHIP8::getIO()
+{
+    return _io;
+}
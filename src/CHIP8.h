@@ -4,8 +4,17 @@
 #include "Cpu.h"
 #include "Memory.h"
 #include "IO.h"
+#include "NullBackend.h"
+#include "MemoryBackend.h"
 #include "Instructions.h"
 #include "JIT.h"
+#include "ControlFlow.h"
+#include "Snapshot.h"
+#include "RewindBuffer.h"
+#include "RunConditions.h"
+#include "TraceRing.h"
+#include "LatencyHistogram.h"
+#include "JITVerifier.h"
 #include "types.h"
 #include "constants.h"
 
@@ -15,6 +24,13 @@
 #include <chrono>
 #include <unistd.h>
 #include <cstddef>
+#include <optional>
+#include <memory>
+#include <random>
+#include <csignal>
+#include <atomic>
+#include <cstdlib>
+#include <string>
 
 using namespace std::chrono_literals;
 
@@ -23,20 +39,179 @@ constexpr auto CLOCK_HZ = TIMER_HZ * 8;
 constexpr auto CLOCKS_PER_TIMER = CLOCK_HZ / TIMER_HZ;
 constexpr auto CYCLE_DURATION = 1s / static_cast<double>(CLOCK_HZ);
 
+struct CHIP8Options
+{
+    //Compile every subroutine reachable from the entry point while loading, instead of waiting for them to get hot
+    bool aot = false;
+
+    JITMode jit = JITMode::Async;
+
+    //Shared pool to compile hot functions on, it has to outlive the CHIP8. Every instance starts its own compile
+    //thread when this is null.
+    CompilePool *compilePool = nullptr;
+
+    //Bytes of history to keep for rewind(), which records a frame every time the timers tick. 0 disables rewinding.
+    size_t rewindBytes = 0;
+
+    //Skip over loops that only wait for the delay timer or a key, instead of executing them. The machine ends up in
+    //exactly the same state either way.
+    bool skipIdle = true;
+
+    //Seed for rnd. Without one every run gets its own, so give one to make a run reproducible.
+    std::optional<uint32_t> seed;
+
+    //Record which instructions run, see getCoverage()
+    CoverageMode coverage = CoverageMode::Disabled;
+
+    //Number of interpreted instructions the trace keeps, see getTrace(). Rounded up to a power of two.
+    size_t traceEntries = 4096;
+
+    //Check every compiled section against the interpreter, throwing a JITDivergence from step() on the first one that
+    //leaves the machine differently. Copies the whole machine per call into a section, so it's for testing the JIT.
+    bool verifyJIT = false;
+
+    //Instructions compiled sections may execute in total before their loops start handing back to the interpreter
+    //on every iteration. Bounds the time a cycle takes when a ROM loops forever in a section, for harnesses running
+    //untrusted ROMs on a cycle budget.
+    uint64_t compiledInstructionLimit = UINT64_MAX;
+};
+
 class CHIP8
 {
 public:
-    explicit CHIP8(const std::vector<byte> &ROM);
+    //The backend shows the display and feeds the keypad, see IO. It has to outlive the CHIP8.
+    CHIP8(const std::vector<byte> &ROM, IOBackend &backend, const CHIP8Options &options = {});
+
+    //Lays out the font and the ROM in memory, the way every CHIP8 starts
+    static void loadROM(Memory &memory, const std::vector<byte> &ROM);
+
+    //Points the cpu at the start of the ROM, with an empty stack
+    static void resetCpu(Cpu &cpu);
 
     void printSingleInstruction(word addr) const;
 
+    //Executes a single cycle: one instruction, plus the compiled function it may call into, input and timers.
+    //If it throws and CHIP8_TRACE_DIR is set, the trace is written to chip8-trace-<pid>-<n>.bin in that directory
+    //first, for chip8_tracedump.
+    void step();
+
+    //Executes up to the given number of cycles as fast as possible, stopping early if the IO asks to exit. Idle loops
+    //are fast-forwarded up to the next timer expiry or input.
+    //Returns the number of cycles executed.
+    uint64_t runFor(uint64_t cycles);
+
+    //Runs at CLOCK_HZ until the IO asks to exit, sleeping through idle loops instead of spinning in them. Times the
+    //loop as it goes, see getRunLoopStats().
     void run();
 
+    //Executes as fast as possible until one of the conditions is met or the IO asks to exit, and returns which. A
+    //breakpoint the previous call stopped at doesn't stop this one again, so calling it again carries on from there.
+    //The breakpoints stay installed in the JIT after it returns, so calling it again with the same ones doesn't
+    //recompile anything. runFor() and run() remove them, step() on its own keeps them.
+    StopReason runUntil(const RunConditions &conditions);
+
+    //Captures the whole machine. Chunks that didn't change since the last snapshot taken or restored are shared with
+    //it, so snapshotting forks of one checkpoint costs little more than what they changed.
+    [[nodiscard]] Snapshot snapshot();
+
+    //Puts the machine back to the snapshot, which may come from any CHIP8. Compiled sections stay valid as long as
+    //the code they were compiled from is the same before and after.
+    void restore(const Snapshot &snapshot);
+
+    //Goes back to the frame recorded the given number of frames before the latest one, or as far back as the history
+    //reaches. rewind(0) just drops whatever ran since the latest frame. Returns the number of frames it went back.
+    size_t rewind(size_t frames);
+
+    [[nodiscard]] uint64_t getCycles() const;
+
+    //Number of times the timers ticked
+    [[nodiscard]] uint64_t getFrames() const;
+
+    //Guest instructions executed by this instance, skipped idle loops and compiled sections included. This is a
+    //performance counter rather than machine state, snapshots don't carry it.
+    [[nodiscard]] uint64_t getInstructions() const;
+
+    [[nodiscard]] JITStats getJITStats() const;
+
+    //Timings of every run() so far, null before the first
+    [[nodiscard]] const RunLoopStats *getRunLoopStats() const;
+
+    //Whether a compiled section is running. The pc is then the section's entry, sections only write it when they
+    //leave. Meant for signal handlers interrupting the thread running this, see GuestProfiler.
+    [[nodiscard]] bool isInSection() const;
+
+    //What executed so far, null unless CHIP8Options::coverage enabled it. Kept across snapshots and rewinds.
+    [[nodiscard]] const Coverage *getCoverage() const;
+
+    //The latest instructions the interpreter executed. Compiled sections and skipped idle loops don't show up in it,
+    //beyond the call into the section.
+    [[nodiscard]] const TraceRing &getTrace() const;
+
+    //Null unless CHIP8Options::verifyJIT enabled it
+    [[nodiscard]] const JITVerifier *getJITVerifier() const;
+
+    [[nodiscard]] const Cpu &getCpu() const;
+
+    [[nodiscard]] const Memory &getMemory() const;
+
+    [[nodiscard]] IO &getIO();
+
 private:
     Cpu _cpu;
     Memory _memory;
     IO _io;
+    //Before the JIT, which keeps a pointer to it
+    std::unique_ptr<Coverage> _coverage;
     JIT _jit;
+
+    uint64_t _cycles = 0;
+    unsigned int _clockCounter = 0;
+
+    //Interpreted and skipped, the JIT counts its own
+    uint64_t _instructions = 0;
+
+    volatile std::sig_atomic_t _inSection = false;
+
+    TraceRing _trace;
+    //Where to write the trace when step() throws, empty to not write it
+    std::string _traceDir;
+
+    std::unique_ptr<JITVerifier> _verifier;
+
+    std::unique_ptr<RunLoopStats> _runLoopStats;
+    //Whether run() is timing the cycles it executes
+    bool _timed = false;
+
+    std::optional<Snapshot> _lastSnapshot;
+
+    std::unique_ptr<RewindBuffer> _rewind;
+
+    bool _skipIdle;
+
+    //Cycle runUntil() last stopped at a breakpoint on
+    std::optional<uint64_t> _breakpointCycle;
+
+    void _step();
+
+    void _writeTrace(const std::string &message) const;
+
+    //Whether the framebuffer or memory conditions hold, hashing the framebuffer only if it was drawn since the last
+    //time
+    std::optional<StopReason> _checkFrame(const RunConditions &conditions, uint64_t &hashedDraws, uint64_t &hash);
+
+    //If the machine is idling, skips up to maxCycles of it and returns the number of cycles skipped
+    uint64_t _skipIdleCycles(uint64_t maxCycles);
+
+    //Counts both timers down by one, as happens every CLOCKS_PER_TIMER cycles
+    void _tickTimers();
+
+    //Passes the given number of cycles without executing anything: only the timers and the beeper run
+    void _advanceClock(uint64_t cycles);
+
+    //Copies src over the memory at offset, marking the bytes it changes as dirty
+    void _loadMemory(const byte *src, size_t offset, size_t size);
+
+    void _recordFrame();
 };
 
 
@@ -0,0 +1,65 @@
+#include "CompilePool.h"
+
+#include <algorithm>
+
+CompilePool::CompilePool(size_t numThreads)
+{
+    for (size_t i = 0; i < std::max<size_t>(numThreads, 1); ++i)
+    {
+        _threads.emplace_back(&CompilePool::_threadLoop, this);
+    }
+}
+
+CompilePool::~CompilePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _exit = true;
+    }
+    _queueCondVar.notify_all();
+
+    for (auto &thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+void CompilePool::submit(const void *owner, std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push_back(Job{owner, std::move(job)});
+    }
+    _queueCondVar.notify_one();
+}
+
+void CompilePool::cancel(const void *owner)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::erase_if(_queue, [owner](const Job &job) { return job.owner == owner; });
+
+    _doneCondVar.wait(lock, [&] { return std::find(_running.cbegin(), _running.cend(), owner) == _running.cend(); });
+}
+
+void CompilePool::_threadLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true)
+    {
+        _queueCondVar.wait(lock, [&] { return !_queue.empty() || _exit; });
+        if (_exit) break;
+
+        Job job = std::move(_queue.front());
+        _queue.pop_front();
+        _running.push_back(job.owner);
+
+        lock.unlock();
+        job.run();
+        lock.lock();
+
+        _running.erase(std::find(_running.begin(), _running.end(), job.owner));
+        _doneCondVar.notify_all();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of threads running compile jobs for any number of JITs. Every job belongs to an owner, which can take back
+//its pending jobs when it goes away.
+class CompilePool final
+{
+public:
+    explicit CompilePool(size_t numThreads);
+
+    ~CompilePool();
+
+    CompilePool(const CompilePool &) = delete;
+
+    CompilePool &operator=(const CompilePool &) = delete;
+
+    void submit(const void *owner, std::function<void()> job);
+
+    //Drops every job of owner that didn't start yet, and waits for the ones that did
+    void cancel(const void *owner);
+
+private:
+    struct Job
+    {
+        const void *owner;
+        std::function<void()> run;
+    };
+
+    void _threadLoop();
+
+    std::mutex _mutex;
+    std::condition_variable _queueCondVar;
+    std::condition_variable _doneCondVar;
+    std::deque<Job> _queue;
+
+    //Owners of the jobs currently running, one entry per job
+    std::vector<const void *> _running;
+
+    bool _exit = false;
+    std::vector<std::thread> _threads;
+};
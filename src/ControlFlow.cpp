@@ -0,0 +1,66 @@
+#include "ControlFlow.h"
+
+std::set<word> findSubroutines(const Memory &memory, word entry)
+{
+    std::set<word> subroutines;
+    std::vector<bool> visited(MEMORY_SIZE, false);
+    std::vector<word> worklist = {entry};
+
+    while (!worklist.empty())
+    {
+        word addr = worklist.back();
+        worklist.pop_back();
+
+        //Odd addresses can't be executed, and anything past the end can't be decoded
+        if ((addr & 1u) || addr + sizeof(opcode) > MEMORY_SIZE || visited[addr]) continue;
+        visited[addr] = true;
+
+        const DecodedInstruction &insn = decode(memory.getOpcode(addr));
+        word next = addr + sizeof(opcode);
+
+        switch (insn.op)
+        {
+            case Op::Jp_imm:
+                worklist.push_back(insn.nnn);
+                break;
+
+            case Op::Call:
+                if (!(insn.nnn & 1u)) subroutines.insert(insn.nnn);
+                worklist.push_back(insn.nnn);
+                worklist.push_back(next);
+                break;
+
+            case Op::Jp_v0_imm:
+                //Every value of V0, half the targets are odd whatever nnn is and get dropped like any odd address
+                for (unsigned int v0 = 0; v0 < JP_V0_TABLE_SIZE; ++v0)
+                {
+                    worklist.push_back((insn.nnn + v0) & MEMORY_MASK);
+                }
+                break;
+
+            case Op::Ret:
+            case Op::Sys:
+            case Op::Invalid:
+                break;
+
+            default:
+                worklist.push_back(next);
+                //Skips can also jump over the next instruction
+                if (insn.isSkip()) worklist.push_back(next + sizeof(opcode));
+                break;
+        }
+    }
+
+    return subroutines;
+}
+
+bool isDelayLoop(word addr, opcode first, opcode second, opcode third)
+{
+    const DecodedInstruction &load = decode(first);
+    const DecodedInstruction &skip = decode(second);
+    const DecodedInstruction &jump = decode(third);
+
+    return load.op == Op::Ld_reg_dt &&
+           skip.op == Op::Se_reg_imm && skip.x == load.x && skip.kk == 0 &&
+           jump.op == Op::Jp_imm && jump.nnn == addr;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Memory.h"
+#include "DecodeTable.h"
+#include "constants.h"
+#include "types.h"
+
+#include <set>
+#include <vector>
+
+//Maximum number of entries followed for a jp V0 table, V0 is a single byte.
+constexpr auto JP_V0_TABLE_SIZE = 0x100;
+
+//Recovers the control-flow graph reachable from `entry` by static analysis of the memory, following direct jumps,
+//calls, both ways of skips and the bounded tables of jp V0. Returns the entry address of every reachable subroutine.
+std::set<word> findSubroutines(const Memory &memory, word entry);
+
+//Number of instructions in a delay timer loop
+constexpr auto DELAY_LOOP_INSNS = 3;
+
+//Whether the instructions at addr are the usual loop waiting for the delay timer to run out:
+//  addr: ld Vx, DT
+//        se Vx, 0
+//        jp addr
+//Until it does, the loop does nothing but keep loading the timer into Vx.
+bool isDelayLoop(word addr, opcode first, opcode second, opcode third);
@@ -0,0 +1,93 @@
+#include "Coverage.h"
+#include "DecodeTable.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <iomanip>
+
+Coverage::Coverage(CoverageMode mode) : _mode(mode)
+{
+}
+
+CoverageMode Coverage::getMode() const
+{
+    return _mode;
+}
+
+void Coverage::markSection(word addr, word numInsns)
+{
+    for (size_t pc = addr; pc < addr + numInsns * sizeof(opcode) && pc < MEMORY_SIZE; pc += sizeof(opcode))
+    {
+        _inSections.set(pc);
+    }
+}
+
+bool Coverage::isCovered(word addr) const
+{
+    addr &= MEMORY_MASK;
+    return _hits[addr] != 0 || _inSections[addr];
+}
+
+uint64_t Coverage::getHits(word addr) const
+{
+    return _hits[addr & MEMORY_MASK];
+}
+
+uint64_t Coverage::getFallThroughs(word addr) const
+{
+    return _fallThroughs[addr & MEMORY_MASK];
+}
+
+uint64_t *Coverage::getHitCounters()
+{
+    return _hits.data();
+}
+
+uint64_t *Coverage::getFallThroughCounters()
+{
+    return _fallThroughs.data();
+}
+
+void Coverage::writeBitmap(std::ostream &stream) const
+{
+    for (size_t addr = 0; addr < MEMORY_SIZE; addr += 8)
+    {
+        byte bits = 0;
+        for (size_t bit = 0; bit < 8; ++bit)
+        {
+            bits |= isCovered(addr + bit) << bit;
+        }
+        stream.put(static_cast<char>(bits));
+    }
+}
+
+void Coverage::writeCounts(std::ostream &stream, const Memory &memory) const
+{
+    stream << "addr\thits\tskipped\tfell through\tin section\n";
+    for (size_t addr = 0; addr + 1 < MEMORY_SIZE; ++addr)
+    {
+        if (!isCovered(addr)) continue;
+
+        stream << "0x" << std::hex << std::setw(3) << std::setfill('0') << addr << std::dec << "\t" << _hits[addr];
+
+        if (decode(memory.getOpcode(addr)).isSkip())
+        {
+            stream << "\t" << _hits[addr] - std::min(_fallThroughs[addr], _hits[addr]) << "\t" << _fallThroughs[addr];
+        } else
+        {
+            stream << "\t-\t-";
+        }
+        stream << "\t" << (_inSections[addr] ? "yes" : "no") << "\n";
+    }
+}
+
+void Coverage::writeFiles(const std::string &prefix, const Memory &memory) const
+{
+    std::ofstream bitmap(prefix + ".bitmap", std::ios::binary | std::ios::trunc);
+    std::ofstream counts(prefix + ".tsv", std::ios::trunc);
+    if (!bitmap.is_open() || !counts.is_open()) throw std::runtime_error("Failed to write the coverage to " + prefix);
+
+    writeBitmap(bitmap);
+    writeCounts(counts, memory);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Memory.h"
+#include "constants.h"
+#include "types.h"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum class CoverageMode : byte
+{
+    Disabled,
+    //Interpreted instructions are counted, compiled sections only mark what they cover every time they are called
+    Sections,
+    //Sections are compiled with counters, so every instruction is counted wherever it runs. Slows sections down.
+    Exact,
+};
+
+//Which guest addresses a CHIP8 executed, how many times, and which way its skips went. Indexed by the address of the
+//instruction. Skips that fell through are counted apart, the ones that skipped are the rest of their hits.
+//
+//Counting is plain increments, a Coverage belongs to the thread running its CHIP8.
+class Coverage final
+{
+public:
+    explicit Coverage(CoverageMode mode);
+
+    [[nodiscard]] CoverageMode getMode() const;
+
+    void hit(word pc, uint64_t count = 1)
+    {
+        _hits[pc & MEMORY_MASK] += count;
+    }
+
+    //The skip at pc didn't skip
+    void fallThrough(word pc, uint64_t count = 1)
+    {
+        _fallThroughs[pc & MEMORY_MASK] += count;
+    }
+
+    //A section compiled from numInsns instructions at addr was called
+    void markSection(word addr, word numInsns);
+
+    //Whether the instruction at addr ran, counted or in a section
+    [[nodiscard]] bool isCovered(word addr) const;
+
+    [[nodiscard]] uint64_t getHits(word addr) const;
+
+    [[nodiscard]] uint64_t getFallThroughs(word addr) const;
+
+    //Where compiled sections count in Exact mode, see JITContext
+    [[nodiscard]] uint64_t *getHitCounters();
+
+    [[nodiscard]] uint64_t *getFallThroughCounters();
+
+    //A bit per address, set if it's covered: bit n % 8 of byte n / 8 stands for address n. MEMORY_SIZE / 8 bytes.
+    void writeBitmap(std::ostream &stream) const;
+
+    //A line per covered address, with its hits and, for the ones holding a skip in memory, how many times they
+    //skipped and fell through. Hits in Sections mode leave out the runs of compiled code.
+    void writeCounts(std::ostream &stream, const Memory &memory) const;
+
+    //Both of the above, to <prefix>.bitmap and <prefix>.tsv
+    void writeFiles(const std::string &prefix, const Memory &memory) const;
+
+private:
+    CoverageMode _mode;
+
+    std::array<uint64_t, MEMORY_SIZE> _hits = {};
+    std::array<uint64_t, MEMORY_SIZE> _fallThroughs = {};
+    std::bitset<MEMORY_SIZE> _inSections;
+};
@@ -1,8 +1,8 @@
 #include "Cpu.h"
 
-Cpu::Cpu()
+Cpu::Cpu(uint32_t seed)
 {
-    std::srand(std::time(nullptr));
+    this->seed(seed);
 }
 
 [[nodiscard]] reg &Cpu::getRegister(RegID reg)
@@ -10,8 +10,25 @@ Cpu::Cpu()
     return registers[static_cast<size_t>(reg)];
 }
 
-[[nodiscard]] imm8 Cpu::getRandom()
+void Cpu::seed(uint32_t seed)
 {
-    return std::rand() & 0xff;
+    //Scramble the seed (the murmur3 finalizer), so close seeds still give unrelated streams
+    seed ^= seed >> 16u;
+    seed *= 0x85ebca6b;
+    seed ^= seed >> 13u;
+    seed *= 0xc2b2ae35;
+    seed ^= seed >> 16u;
+
+    //xorshift never leaves 0
+    rngState = seed != 0 ? seed : 1;
 }
 
+[[nodiscard]] imm8 Cpu::getRandom()
+{
+    rngState ^= rngState << 13u;
+    rngState ^= rngState >> 17u;
+    rngState ^= rngState << 5u;
+
+    //The high bits are the better ones
+    return rngState >> 24u;
+}
@@ -3,17 +3,20 @@
 #include "types.h"
 #include "RegID.h"
 #include <array>
-#include <cstdlib>
-#include <ctime>
+#include <cstdint>
 
 class Cpu
 {
 public:
-    Cpu();
+    //Instances seeded the same see the same random numbers
+    explicit Cpu(uint32_t seed = 0);
 
     [[nodiscard]] reg &getRegister(RegID reg);
 
-    [[nodiscard]] static imm8 getRandom();
+    void seed(uint32_t seed);
+
+    //xorshift32. Rnd_reg_imm::compile emits the same steps inline, keep the two in sync.
+    [[nodiscard]] imm8 getRandom();
 
     reg registers[16] = {};
     volatile word indexRegister = 0;
@@ -22,6 +25,8 @@ public:
 
     volatile byte soundTimer = 0;
     volatile byte delayTimer = 0;
+
+    uint32_t rngState = 1;
 };
 
 
@@ -0,0 +1,156 @@
+#include "DecodeTable.h"
+
+static constexpr Op decodeOp(opcode opcode)
+{
+    switch (getNibble(opcode, 3))
+    {
+        case 0x0:
+            if (opcode == 0x00e0) return Op::Cls;
+            else if (opcode == 0x00ee) return Op::Ret;
+            else return Op::Sys;
+
+        case 0x1:
+            return Op::Jp_imm;
+
+        case 0x2:
+            return Op::Call;
+
+        case 0x3:
+            //3xkk - SE Vx, kk
+            return Op::Se_reg_imm;
+
+        case 0x4:
+            //4xkk - SNE Vx, kk
+            return Op::Sne_reg_imm;
+
+        case 0x5:
+            //5xy0 - SE Vx, Vy
+            if (getNibble(opcode) != 0) break;
+            return Op::Se_reg_reg;
+
+        case 0x6:
+            //6xkk - LD Vx, kk
+            return Op::Ld_reg_imm;
+
+        case 0x7:
+            //7xkk - ADD Vx, kk
+            return Op::Add_reg_imm;
+
+        case 0x8:
+            switch (getNibble(opcode))
+            {
+                case 0x0:
+                    return Op::Ld_reg_reg;
+                case 0x1:
+                    return Op::Or_reg_reg;
+                case 0x2:
+                    return Op::And_reg_reg;
+                case 0x3:
+                    return Op::Xor_reg_reg;
+                case 0x4:
+                    return Op::Add_reg_reg;
+                case 0x5:
+                    return Op::Sub_reg_reg;
+                case 0x6:
+                    return Op::Shr_reg;
+                case 0x7:
+                    return Op::Subn_reg_reg;
+                case 0xe:
+                    return Op::Shl_reg;
+                default:
+                    break;
+            }
+            break;
+
+        case 0x9:
+            if (getNibble(opcode) != 0) break;
+            return Op::Sne_reg_reg;
+
+        case 0xA:
+            return Op::Ld_I_imm;
+
+        case 0xB:
+            return Op::Jp_v0_imm;
+
+        case 0xC:
+            return Op::Rnd_reg_imm;
+
+        case 0xD:
+            return Op::Drw_reg_reg_imm;
+
+        case 0xE:
+            switch (getByte(opcode))
+            {
+                case 0x9E:
+                    return Op::Skp_reg;
+                case 0xA1:
+                    return Op::Sknp_reg;
+                default:
+                    break;
+            }
+            //Unknown Ex opcodes have always been decoded like their Fx counterparts
+            [[fallthrough]];
+
+        case 0xF:
+            switch (getByte(opcode))
+            {
+                case 0x07:
+                    return Op::Ld_reg_dt;
+                case 0x0A:
+                    return Op::Ld_reg_K;
+                case 0x15:
+                    return Op::Ld_dt_reg;
+                case 0x18:
+                    return Op::Ld_st_reg;
+                case 0x1E:
+                    return Op::Add_I_reg;
+                case 0x29:
+                    return Op::Ld_F_reg;
+                case 0x33:
+                    return Op::Ld_B_reg;
+                case 0x55:
+                    return Op::Ld_I_regs;
+                case 0x65:
+                    return Op::Ld_regs_I;
+                default:
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return Op::Invalid;
+}
+
+static constexpr std::array<DecodedInstruction, DECODE_TABLE_SIZE> makeDecodeTable()
+{
+    std::array<DecodedInstruction, DECODE_TABLE_SIZE> table = {};
+
+    for (size_t i = 0; i < DECODE_TABLE_SIZE; ++i)
+    {
+        auto opcode = static_cast<word>(i);
+        table[i] = DecodedInstruction{decodeOp(opcode), getNibble(opcode, 2), getNibble(opcode, 1),
+                                      getNibble(opcode), getByte(opcode), getAddress(opcode)};
+    }
+
+    return table;
+}
+
+constinit const std::array<DecodedInstruction, DECODE_TABLE_SIZE> DECODE_TABLE = makeDecodeTable();
+
+const char *opName(Op op)
+{
+    //In the order of Op
+    static const char *const NAMES[] = {
+            "Invalid", "Sys", "Cls", "Ret", "Jp_imm", "Call", "Se_reg_imm", "Sne_reg_imm", "Se_reg_reg", "Ld_reg_imm",
+            "Add_reg_imm", "Ld_reg_reg", "Or_reg_reg", "And_reg_reg", "Xor_reg_reg", "Add_reg_reg", "Sub_reg_reg",
+            "Shr_reg", "Subn_reg_reg", "Shl_reg", "Sne_reg_reg", "Ld_I_imm", "Jp_v0_imm", "Rnd_reg_imm",
+            "Drw_reg_reg_imm", "Skp_reg", "Sknp_reg", "Ld_reg_dt", "Ld_reg_K", "Ld_dt_reg", "Ld_st_reg", "Add_I_reg",
+            "Ld_F_reg", "Ld_B_reg", "Ld_I_regs", "Ld_regs_I",
+    };
+    static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == NUM_OPS);
+
+    return NAMES[static_cast<size_t>(op)];
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "types.h"
+#include "RegID.h"
+
+#include <array>
+
+//Every operation the decoder knows about. The names match the classes in Instructions.h.
+enum class Op : byte
+{
+    Invalid,
+    Sys,
+    Cls,
+    Ret,
+    Jp_imm,
+    Call,
+    Se_reg_imm,
+    Sne_reg_imm,
+    Se_reg_reg,
+    Ld_reg_imm,
+    Add_reg_imm,
+    Ld_reg_reg,
+    Or_reg_reg,
+    And_reg_reg,
+    Xor_reg_reg,
+    Add_reg_reg,
+    Sub_reg_reg,
+    Shr_reg,
+    Subn_reg_reg,
+    Shl_reg,
+    Sne_reg_reg,
+    Ld_I_imm,
+    Jp_v0_imm,
+    Rnd_reg_imm,
+    Drw_reg_reg_imm,
+    Skp_reg,
+    Sknp_reg,
+    Ld_reg_dt,
+    Ld_reg_K,
+    Ld_dt_reg,
+    Ld_st_reg,
+    Add_I_reg,
+    Ld_F_reg,
+    Ld_B_reg,
+    Ld_I_regs,
+    Ld_regs_I,
+};
+
+constexpr size_t NUM_OPS = static_cast<size_t>(Op::Ld_regs_I) + 1;
+
+//The name of the class in Instructions.h
+const char *opName(Op op);
+
+//An opcode with its operands already extracted. Which of them mean anything depends on op, the rest are whatever
+//the opcode had in their place.
+struct DecodedInstruction
+{
+    Op op;
+    //xkk, xyn
+    byte x;
+    byte y;
+    imm4 n;
+    imm8 kk;
+    //nnn
+    addr12 nnn;
+
+    [[nodiscard]] RegID regX() const
+    {
+        return static_cast<RegID>(x);
+    }
+
+    [[nodiscard]] RegID regY() const
+    {
+        return static_cast<RegID>(y);
+    }
+
+    //Instructions that skip the next one if their condition holds
+    [[nodiscard]] bool isSkip() const
+    {
+        return op == Op::Se_reg_imm || op == Op::Sne_reg_imm || op == Op::Se_reg_reg || op == Op::Sne_reg_reg ||
+               op == Op::Skp_reg || op == Op::Sknp_reg;
+    }
+};
+
+constexpr size_t DECODE_TABLE_SIZE = 0x10000;
+
+//Indexed by the full opcode, and generated entirely at compile time.
+extern const std::array<DecodedInstruction, DECODE_TABLE_SIZE> DECODE_TABLE;
+
+inline const DecodedInstruction &decode(opcode opcode)
+{
+    return DECODE_TABLE[opcode];
+}
@@ -0,0 +1,240 @@
+#include "GuestProfiler.h"
+#include "DecodeTable.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//The buffer of the thread the signal interrupted. Plain data without a constructor, so reading it from a signal
+//handler is safe.
+static constinit thread_local std::atomic<void *> currentBuffer = nullptr;
+
+constexpr int PROFILER_SIGNAL = SIGPROF;
+
+GuestProfiler::GuestProfiler(std::chrono::microseconds interval, size_t samplesPerThread)
+        : _interval(interval), _samplesPerThread(samplesPerThread)
+{
+    struct sigaction act = {};
+    act.sa_sigaction = &_handleSignal;
+    act.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    if (sigaction(PROFILER_SIGNAL, &act, &_previousAction) != 0)
+    {
+        throw std::runtime_error("Failed to install the profiler's signal handler");
+    }
+}
+
+GuestProfiler::~GuestProfiler()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &buffer : _buffers)
+    {
+        if (buffer->chip8 != nullptr) timer_delete(buffer->timer);
+    }
+
+    sigaction(PROFILER_SIGNAL, &_previousAction, nullptr);
+}
+
+void GuestProfiler::attach(const CHIP8 &chip8)
+{
+    if (currentBuffer.load() != nullptr) throw std::runtime_error("This thread is already being profiled");
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->chip8 = &chip8;
+    buffer->samples = std::make_unique<Sample[]>(_samplesPerThread);
+    buffer->capacity = _samplesPerThread;
+
+    //Delivered to this thread, every interval of its CPU time
+    sigevent event = {};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = PROFILER_SIGNAL;
+    event._sigev_un._tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &buffer->timer) != 0)
+    {
+        throw std::runtime_error("Failed to create the profiler's timer");
+    }
+
+    currentBuffer.store(buffer.get());
+
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(_interval);
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(_interval - seconds);
+    itimerspec spec = {};
+    spec.it_interval.tv_sec = seconds.count();
+    spec.it_interval.tv_nsec = nanoseconds.count();
+    spec.it_value = spec.it_interval;
+    timer_settime(buffer->timer, 0, &spec, nullptr);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffers.push_back(std::move(buffer));
+}
+
+void GuestProfiler::detach()
+{
+    auto *buffer = static_cast<ThreadBuffer *>(currentBuffer.load());
+    if (buffer == nullptr) return;
+
+    //A signal still pending after this finds no buffer and does nothing
+    timer_delete(buffer->timer);
+    currentBuffer.store(nullptr);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    buffer->chip8 = nullptr;
+}
+
+void GuestProfiler::_handleSignal(int signum, siginfo_t *info, void *context)
+{
+    auto *buffer = static_cast<ThreadBuffer *>(currentBuffer.load(std::memory_order_relaxed));
+    if (buffer == nullptr) return;
+
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index == buffer->capacity)
+    {
+        buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    const Cpu &cpu = buffer->chip8->getCpu();
+    const Memory &memory = buffer->chip8->getMemory();
+    Sample &sample = buffer->samples[index];
+
+    sample.pc = cpu.pc;
+    sample.inSection = buffer->chip8->isInSection();
+
+    //Every call pushed its return address, walk them from the innermost out. The entry of each function is read off
+    //the call before the return address, the frame is named after the call site if that's no longer a call.
+    word frames[MAX_DEPTH];
+    size_t depth = 0;
+    for (word slot = cpu.sp; slot > STACK_START && slot + 1 < MEMORY_SIZE && depth < MAX_DEPTH; slot -= sizeof(word))
+    {
+        word ret = memory.buf[slot] | (memory.buf[slot + 1] << 8u);
+        word site = (ret - sizeof(opcode)) & MEMORY_MASK;
+        const DecodedInstruction &call = decode((memory.buf[site] << 8u) | memory.buf[(site + 1) & MEMORY_MASK]);
+
+        frames[depth++] = call.op == Op::Call ? call.nnn : site;
+    }
+
+    //The ROM's entry is the outermost function, unless the stack was too deep to get there
+    size_t out = 0;
+    if (cpu.sp <= STACK_START + MAX_DEPTH * sizeof(word)) sample.functions[out++] = ROM_START;
+    while (depth > 0)
+    {
+        sample.functions[out++] = frames[--depth];
+    }
+    sample.depth = out;
+
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+std::vector<GuestProfiler::Sample> GuestProfiler::_collect(uint64_t &dropped) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<Sample> samples;
+    dropped = 0;
+    for (const auto &buffer : _buffers)
+    {
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        samples.insert(samples.end(), buffer->samples.get(), buffer->samples.get() + count);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    return samples;
+}
+
+void GuestProfiler::writeFlat(std::ostream &stream) const
+{
+    uint64_t dropped;
+    std::vector<Sample> samples = _collect(dropped);
+
+    struct Counts
+    {
+        uint64_t self = 0;
+        uint64_t total = 0;
+        uint64_t compiled = 0;
+    };
+
+    std::map<word, Counts> functions;
+    std::map<word, Counts> pcs;
+    for (const Sample &sample : samples)
+    {
+        if (sample.depth == 0) continue;
+
+        Counts &self = functions[sample.functions[sample.depth - 1]];
+        self.self++;
+        self.compiled += sample.inSection;
+
+        //A recursive function is only counted once per sample
+        std::vector<word> seen(sample.functions.begin(), sample.functions.begin() + sample.depth);
+        std::sort(seen.begin(), seen.end());
+        seen.erase(std::unique(seen.begin(), seen.end()), seen.end());
+        for (word function : seen)
+        {
+            functions[function].total++;
+        }
+
+        Counts &pc = pcs[sample.pc];
+        pc.self++;
+        pc.total++;
+        pc.compiled += sample.inSection;
+    }
+
+    double interval = std::chrono::duration<double, std::milli>(_interval).count();
+    auto percent = [&](uint64_t count) { return samples.empty() ? 0.0 : 100.0 * count / samples.size(); };
+
+    auto write = [&](const char *title, const std::map<word, Counts> &counts) {
+        std::vector<std::pair<word, Counts>> sorted(counts.cbegin(), counts.cend());
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+            return a.second.self != b.second.self ? a.second.self > b.second.self : a.second.total > b.second.total;
+        });
+
+        stream << "\n" << title << "\tself\tself ms\tself %\ttotal %\tcompiled %\n";
+        for (const auto &[addr, count] : sorted)
+        {
+            stream << "0x" << std::hex << std::setw(3) << std::setfill('0') << addr << std::dec << std::setfill(' ')
+                   << "\t" << count.self << "\t" << std::fixed << std::setprecision(1) << count.self * interval
+                   << "\t" << percent(count.self) << "\t" << percent(count.total) << "\t"
+                   << (count.self ? 100.0 * count.compiled / count.self : 0.0) << "\n";
+        }
+    };
+
+    stream << samples.size() << " samples every " << interval << "ms of CPU time, " << dropped << " dropped\n";
+    write("function", functions);
+
+    //The pc of a compiled section is its entry, so it isn't any more precise than the function
+    write("pc", pcs);
+}
+
+void GuestProfiler::writeFolded(std::ostream &stream) const
+{
+    uint64_t dropped;
+    std::vector<Sample> samples = _collect(dropped);
+
+    std::map<std::vector<word>, uint64_t> stacks;
+    for (const Sample &sample : samples)
+    {
+        stacks[std::vector<word>(sample.functions.begin(), sample.functions.begin() + sample.depth)]++;
+    }
+
+    for (const auto &[stack, count] : stacks)
+    {
+        for (size_t i = 0; i < stack.size(); ++i)
+        {
+            stream << (i == 0 ? "" : ";") << "0x" << std::hex << std::setw(3) << std::setfill('0') << stack[i];
+        }
+        stream << std::dec << " " << count << "\n";
+    }
+}
+
+void GuestProfiler::writeFiles(const std::string &prefix) const
+{
+    std::ofstream flat(prefix + ".txt");
+    std::ofstream folded(prefix + ".folded");
+    if (!flat.is_open() || !folded.is_open()) throw std::runtime_error("Failed to write the profile to " + prefix);
+
+    writeFlat(flat);
+    writeFolded(folded);
+}
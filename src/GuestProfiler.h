@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CHIP8.h"
+#include "types.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <signal.h>
+#include <string>
+#include <vector>
+
+//Sampling profiler for the guest program. A timer on the thread's CPU time interrupts the thread running a CHIP8, and
+//the signal handler records where the guest is: its pc, whether a compiled section was running, and the functions on
+//the guest stack. Samples go to a fixed buffer per thread that only that thread's signal handler writes, so taking one
+//costs no locks and no allocations.
+//
+//Only CPU time counts, a thread sleeping in CHIP8::run() isn't sampled.
+class GuestProfiler final
+{
+public:
+    //Deepest guest stack recorded, the outermost frames are cut off beyond it
+    static constexpr size_t MAX_DEPTH = 16;
+
+    //Samples over the buffer of a thread are dropped and counted
+    explicit GuestProfiler(std::chrono::microseconds interval = std::chrono::microseconds(1000),
+                           size_t samplesPerThread = 1u << 20u);
+
+    //Every thread has to detach() first
+    ~GuestProfiler();
+
+    GuestProfiler(const GuestProfiler &) = delete;
+
+    GuestProfiler &operator=(const GuestProfiler &) = delete;
+
+    //Starts sampling chip8 on the calling thread, which has to be the one running it, until detach(). A thread
+    //samples one CHIP8 at a time.
+    void attach(const CHIP8 &chip8);
+
+    void detach();
+
+    //Samples and time per guest function, both by itself and with everything it called, and the hottest pcs
+    void writeFlat(std::ostream &stream) const;
+
+    //A line per distinct stack with its number of samples, outermost function first, as flamegraph.pl and speedscope
+    //read them
+    void writeFolded(std::ostream &stream) const;
+
+    //Both of the above, to <prefix>.txt and <prefix>.folded
+    void writeFiles(const std::string &prefix) const;
+
+private:
+    struct Sample
+    {
+        word pc;
+        bool inSection;
+        byte depth;
+        //Entry addresses of the functions on the stack, outermost first. The pc is in the last one.
+        std::array<word, MAX_DEPTH + 1> functions;
+    };
+
+    struct ThreadBuffer
+    {
+        const CHIP8 *chip8;
+        timer_t timer;
+
+        std::unique_ptr<Sample[]> samples;
+        size_t capacity;
+        //Written by the signal handler only
+        std::atomic<size_t> count = 0;
+        std::atomic<uint64_t> dropped = 0;
+    };
+
+    static void _handleSignal(int signum, siginfo_t *info, void *context);
+
+    //Everything collected so far, across threads
+    [[nodiscard]] std::vector<Sample> _collect(uint64_t &dropped) const;
+
+    std::chrono::microseconds _interval;
+    size_t _samplesPerThread;
+
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+
+    struct sigaction _previousAction = {};
+};
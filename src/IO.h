@@ -1,6 +1,6 @@
 #pragma once
 
-//IO.h, IO.cpp, SDLHelper.h, SDLHelper.cpp, are almost fully copied, with some changes, from https://github.com/omerk2511/chip-8 .
+//IO.h, IO.cpp, SDLBackend.h, SDLBackend.cpp, SDLHelper.h, SDLHelper.cpp, are almost fully copied, with some changes, from https://github.com/omerk2511/chip-8 .
 //
 //MIT License
 //
@@ -24,37 +24,23 @@
 //OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 //SOFTWARE.
 
-#include "SDLHelper.h"
+#include "IOBackend.h"
+#include "LatencyHistogram.h"
 #include "types.h"
-#include <unordered_map>
 #include <cstdio>
-#include <iostream>
 #include <optional>
 #include <array>
 
-
-constexpr auto PIXEL_WIDTH = 64;
-constexpr auto PIXEL_HEIGHT = 32;
-
-static constexpr size_t NUM_PIXELS = PIXEL_WIDTH * PIXEL_HEIGHT;
-
-constexpr auto SIZE_MULTIPLIER = 20;
-
-constexpr auto WINDOW_WIDTH = PIXEL_WIDTH * SIZE_MULTIPLIER;
-constexpr auto WINDOW_HEIGHT = PIXEL_HEIGHT * SIZE_MULTIPLIER;
-
-static constexpr size_t KEYPAD_SIZE = 16;
-
 extern const size_t FONT_SPRITE_SIZE;
 
+//The machine's side of the display and keypad. The framebuffer and the keypad are always maintained here, whatever
+//the backend is, the backend only shows the frames and feeds the keys.
 class IO final
 {
 public:
-    explicit IO(const std::string &windowName);
-
-    ~IO();
+    explicit IO(IOBackend &backend);
 
-    static void beep();
+    void beep();
 
     void clear();
 
@@ -62,23 +48,37 @@ public:
 
     void pollEvents();
 
+    //See IOBackend::getIdlePolls()
+    [[nodiscard]] uint64_t getIdlePolls(uint64_t max) const;
+
+    void skipPolls(uint64_t count);
+
     std::array<bool, NUM_PIXELS> &getBitmap();
 
+    std::array<bool, KEYPAD_SIZE> &getKeys();
+
     [[nodiscard]] bool isPressed(byte key) const;
 
     std::optional<byte> getPressedKey();
 
     [[nodiscard]] bool getExitFlag() const;
 
+    //Records the time every draw() and pollEvents() takes into the given histograms, until called with null ones
+    void setTimings(LatencyHistogram *draw, LatencyHistogram *poll);
+
+    //Number of frames drawn so far. The bitmap only changes right before one, so this tells whether it changed.
+    [[nodiscard]] uint64_t getDrawCount() const;
+
 private:
-    SDLHelper::ptr<SDLHelper::window> _window;
-    SDLHelper::ptr<SDLHelper::renderer> _renderer;
-    SDLHelper::ptr<SDLHelper::texture> _texture;
+    IOBackend &_backend;
 
     std::array<bool, KEYPAD_SIZE> _keys;
     std::array<bool, NUM_PIXELS> _bitmap;
     bool _exit_flag;
-    bool _sdl_disabled = false;
+    uint64_t _drawCount = 0;
+
+    LatencyHistogram *_drawTiming = nullptr;
+    LatencyHistogram *_pollTiming = nullptr;
 };
 
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+constexpr auto PIXEL_WIDTH = 64;
+constexpr auto PIXEL_HEIGHT = 32;
+
+static constexpr size_t NUM_PIXELS = PIXEL_WIDTH * PIXEL_HEIGHT;
+
+static constexpr size_t KEYPAD_SIZE = 16;
+
+//Presentation and input for an IO. The emulation core only talks to the display and the keypad through this, so it
+//can be embedded without any windowing library.
+class IOBackend
+{
+public:
+    virtual ~IOBackend() = default;
+
+    //Shows the current framebuffer
+    virtual void present(const std::array<bool, NUM_PIXELS> &bitmap) = 0;
+
+    //Applies pending input to the keypad, and sets exitFlag if the user asked to quit
+    virtual void pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag) = 0;
+
+    //Number of the next polls, up to max, that the machine may skip while it idles, see skipPolls(). Skipping is fine
+    //when they wouldn't change anything, or when whatever happens meanwhile just waits for the next poll.
+    [[nodiscard]] virtual uint64_t getIdlePolls(uint64_t max) const
+    {
+        return 0;
+    }
+
+    //Called instead of count polls, count never being more than getIdlePolls() allowed
+    virtual void skipPolls(uint64_t count)
+    {}
+
+    //Called every cycle the sound timer is active
+    virtual void beep()
+    {
+        //Extremely lazy beep
+        putchar(0x7);
+    }
+};
@@ -0,0 +1,140 @@
+#include "InputLog.h"
+#include "BinaryFile.h"
+
+static constexpr char MAGIC[4] = {'C', '8', 'I', 'L'};
+static constexpr byte VERSION = 1;
+static constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 2 + sizeof(uint32_t) + sizeof(uint64_t);
+
+static uint64_t readVarint(const std::vector<byte> &data, size_t &pos)
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if (pos >= data.size()) throw std::runtime_error("Truncated input log");
+
+        byte b = data[pos++];
+        value |= static_cast<uint64_t>(b & 0x7fu) << shift;
+        if (!(b & 0x80u)) return value;
+    }
+
+    throw std::runtime_error("Invalid input log");
+}
+
+uint64_t InputLog::hashROM(const std::vector<byte> &ROM)
+{
+    //FNV-1a
+    uint64_t hash = 0xcbf29ce484222325;
+    for (byte b : ROM)
+    {
+        hash ^= b;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+InputLog readInputLog(const char *filename)
+{
+    std::vector<byte> data = readBinaryFile(filename);
+
+    if (data.size() < HEADER_SIZE || !std::equal(std::begin(MAGIC), std::end(MAGIC), data.begin()))
+    {
+        throw std::runtime_error(std::string(filename) + " is not an input log");
+    }
+    if (data[sizeof(MAGIC)] != VERSION) throw std::runtime_error("Unsupported input log version");
+
+    size_t pos = sizeof(MAGIC) + 1;
+
+    InputLog log;
+    if (data[pos] > static_cast<byte>(JITMode::Disabled)) throw std::runtime_error("Invalid JIT mode in input log");
+    log.jitMode = static_cast<JITMode>(data[pos++]);
+    log.seed = readLE<uint32_t>(data, pos);
+    log.romHash = readLE<uint64_t>(data, pos);
+
+    uint64_t cycle = 0;
+    while (pos < data.size())
+    {
+        uint64_t record = readVarint(data, pos);
+        cycle += record >> 1u;
+
+        if (record & 1u)
+        {
+            log.endCycle = cycle;
+            break;
+        }
+
+        log.changes.push_back(InputLog::Change{cycle, readLE<uint16_t>(data, pos)});
+    }
+
+    return log;
+}
+
+uint16_t keysToMask(const std::array<bool, KEYPAD_SIZE> &keys)
+{
+    uint16_t mask = 0;
+    for (size_t key = 0; key < KEYPAD_SIZE; ++key)
+    {
+        mask |= static_cast<uint16_t>(keys[key]) << key;
+    }
+    return mask;
+}
+
+std::array<bool, KEYPAD_SIZE> maskToKeys(uint16_t mask)
+{
+    std::array<bool, KEYPAD_SIZE> keys;
+    for (size_t key = 0; key < KEYPAD_SIZE; ++key)
+    {
+        keys[key] = (mask >> key) & 1u;
+    }
+    return keys;
+}
+
+InputLogWriter::InputLogWriter(const char *filename, JITMode jitMode, uint32_t seed, uint64_t romHash)
+        : _file(filename, std::ios::binary | std::ios::trunc)
+{
+    if (!_file.is_open())
+    {
+        throw std::runtime_error(std::string("Failed to open ") + filename);
+    }
+
+    _file.write(MAGIC, sizeof(MAGIC));
+    _file.put(static_cast<char>(VERSION));
+    _file.put(static_cast<char>(jitMode));
+    writeLE(_file, seed);
+    writeLE(_file, romHash);
+}
+
+void InputLogWriter::record(uint64_t cycle, uint16_t keys)
+{
+    if (_finished) throw std::runtime_error("The input log is already finished");
+
+    _writeRecord(cycle, false);
+    writeLE(_file, keys);
+}
+
+void InputLogWriter::finish(uint64_t cycle)
+{
+    if (_finished) return;
+
+    _writeRecord(cycle, true);
+    _file.flush();
+    _finished = true;
+}
+
+bool InputLogWriter::isFinished() const
+{
+    return _finished;
+}
+
+void InputLogWriter::_writeRecord(uint64_t cycle, bool end)
+{
+    uint64_t value = ((cycle - _lastCycle) << 1u) | end;
+    _lastCycle = cycle;
+
+    do
+    {
+        byte b = value & 0x7fu;
+        value >>= 7u;
+        _file.put(static_cast<char>(b | (value ? 0x80u : 0u)));
+    } while (value);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "IOBackend.h"
+#include "JIT.h"
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//Keypad changes of a session, enough to replay it exactly. Cycles count IO polls since the machine started, which is
+//one per CHIP8::step(). On disk, all little endian:
+//  "C8IL", version, JIT mode, seed (u32), FNV-1a of the ROM (u64)
+//  then per record: LEB128 of (cycles since the previous record << 1 | end), and the keypad (u16) unless end is set
+struct InputLog
+{
+    struct Change
+    {
+        uint64_t cycle;
+        //Bit n for key n, the whole keypad right after that cycle's poll
+        uint16_t keys;
+    };
+
+    JITMode jitMode;
+    uint32_t seed;
+    uint64_t romHash;
+
+    std::vector<Change> changes;
+
+    //Cycle the session exited at. Missing if the recording was cut short.
+    std::optional<uint64_t> endCycle;
+
+    static uint64_t hashROM(const std::vector<byte> &ROM);
+};
+
+InputLog readInputLog(const char *filename);
+
+uint16_t keysToMask(const std::array<bool, KEYPAD_SIZE> &keys);
+
+std::array<bool, KEYPAD_SIZE> maskToKeys(uint16_t mask);
+
+//Writes an InputLog as the session goes
+class InputLogWriter final
+{
+public:
+    InputLogWriter(const char *filename, JITMode jitMode, uint32_t seed, uint64_t romHash);
+
+    void record(uint64_t cycle, uint16_t keys);
+
+    //Writes the end record, nothing can be recorded after it
+    void finish(uint64_t cycle);
+
+    [[nodiscard]] bool isFinished() const;
+
+private:
+    void _writeRecord(uint64_t cycle, bool end);
+
+    std::ofstream _file;
+    uint64_t _lastCycle = 0;
+    bool _finished = false;
+};
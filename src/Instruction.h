@@ -6,26 +6,33 @@
 #include "Memory.h"
 #include "IO.h"
 #include "JITSection.h"
+#include "JITContext.h"
 #include "asmjit/asmjit.h"
 
+//All of these are callee-saved, so they survive calls into host helpers.
 namespace JIT_BASES
 {
-    constexpr auto DIRTY_MAP_BASE = asmjit::x86::r9;
-    constexpr auto MEMORY_BASE = asmjit::x86::r10;
-    constexpr auto CPU_BASE = asmjit::x86::r11;
+    constexpr auto CONTEXT_BASE = asmjit::x86::rbx;
+    constexpr auto DIRTY_MAP_BASE = asmjit::x86::r12;
+    constexpr auto MEMORY_BASE = asmjit::x86::r13;
+    constexpr auto CPU_BASE = asmjit::x86::r14;
 }
 
+//Instructions are immutable, every opcode has a single shared instance of its instruction (see parseInstruction).
 class Instruction
 {
 public:
+    virtual ~Instruction() = default;
+
     virtual std::ostream &print(std::ostream &stream) const = 0;
 
-    virtual void execute(Cpu &cpu, Memory &memory, IO &io) = 0;
+    virtual void execute(Cpu &cpu, Memory &memory, IO &io) const = 0;
 
     //If the compilation was successful, the assembly will be emitted and the function will return true.
     //Otherwise, assembly will not be emitted and the function will return false.
     //Compiled instructions expect to be called with the PC pointing to the next insn, like all instructions.
-    virtual bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) = 0;
+    //The emitted code is shared between instances, so it may only reach the instance through JIT_BASES.
+    virtual bool compile(JITSection &jit, addr12 pc) const = 0;
 };
 
 std::ostream &operator<<(std::ostream &stream, const Instruction &insn);
@@ -10,23 +10,24 @@ namespace Instructions
         return stream << "Invalid Instruction (0x" << std::hex << _opcode << ")";
     }
 
-    void Invalid::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Invalid::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
 	std::stringstream stream;
 	stream << std::hex << _opcode;
 	throw std::runtime_error("Tried to run an invalid instruction " + stream.str());
     }
 
-    bool Invalid::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Invalid::compile(JITSection &jit, addr12 pc) const
     {
-        throw std::runtime_error("Tried to run an invalid instruction: ");
+        //Sections can run into data, only throw if the interpreter actually gets here
+        return false;
     }
 
 
     Sys::Sys(addr12 addr) : _addr(addr)
     {}
 
-    void Sys::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Sys::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         throw std::runtime_error("Sys executed");
     }
@@ -36,12 +37,12 @@ namespace Instructions
         return stream << "sys 0x" << std::hex << _addr;
     }
 
-    bool Sys::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Sys::compile(JITSection &jit, addr12 pc) const
     {
-        throw std::runtime_error("Sys executed");
+        return false;
     }
 
-    void Cls::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Cls::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         io.clear();
         io.draw();
@@ -52,28 +53,15 @@ namespace Instructions
         return stream << "cls";
     }
 
-    bool Cls::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Cls::compile(JITSection &jit, addr12 pc) const
     {
-        auto io_ptr = reinterpret_cast<uint64_t>(&io);
-        auto clear = &IO::clear;
-        auto draw = &IO::draw;
-        uint64_t clearPtr = 0;
-        uint64_t drawPtr = 0;
-        memcpy(&clearPtr, &clear, sizeof(clearPtr));
-        memcpy(&drawPtr, &draw, sizeof(drawPtr));
-
-        jit.assm.mov(asmjit::x86::rdi, io_ptr);
-        jit.assm.mov(asmjit::x86::rax, clearPtr);
-        jit.assm.call(asmjit::x86::rax);
-
-        jit.assm.mov(asmjit::x86::rdi, io_ptr);
-        jit.assm.mov(asmjit::x86::rax, drawPtr);
-        jit.assm.call(asmjit::x86::rax);
+        jit.assm.mov(asmjit::x86::rdi, asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, io)));
+        jit.assm.call(asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, clearScreen)));
 
         return true;
     }
 
-    void Ret::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ret::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.pc = memory.get<word>(cpu.sp);
         cpu.sp -= sizeof(word);
@@ -84,7 +72,7 @@ namespace Instructions
         return stream << "ret";
     }
 
-    bool Ret::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ret::compile(JITSection &jit, addr12 pc) const
     {
         return false;
     }
@@ -92,7 +80,7 @@ namespace Instructions
     Jp_imm::Jp_imm(addr12 target) : target(target)
     {}
 
-    void Jp_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Jp_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.pc = target;
     }
@@ -102,8 +90,11 @@ namespace Instructions
         return stream << "jp 0x" << std::hex << target;
     }
 
-    bool Jp_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Jp_imm::compile(JITSection &jit, addr12 pc) const
     {
+        //Left to the interpreter, which fails on the odd pc when it gets there
+        if (target & 1u) return false;
+
         auto label = jit.getLabelForAddress(target);
         if (label.has_value())
         {
@@ -118,7 +109,7 @@ namespace Instructions
     Call::Call(addr12 target) : target(target)
     {}
 
-    void Call::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Call::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.sp += sizeof(word);
         memory.put<word>(cpu.sp, cpu.pc);
@@ -130,7 +121,7 @@ namespace Instructions
         return stream << "call 0x" << std::hex << target;
     }
 
-    bool Call::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Call::compile(JITSection &jit, addr12 pc) const
     {
         return false;
     }
@@ -138,7 +129,7 @@ namespace Instructions
     Se_reg_imm::Se_reg_imm(RegID reg, imm8 byte) : _reg(reg), _byte(byte)
     {}
 
-    void Se_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Se_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         if (cpu.getRegister(_reg) == _byte)
         {
@@ -151,7 +142,7 @@ namespace Instructions
         return stream << "se " << _reg << ", " << std::hex << _byte;
     }
 
-    bool Se_reg_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Se_reg_imm::compile(JITSection &jit, addr12 pc) const
     {
         auto targetLabel = jit.getLabelForAddress(pc + sizeof(opcode));
         if (targetLabel.has_value())
@@ -168,7 +159,7 @@ namespace Instructions
     Sne_reg_imm::Sne_reg_imm(RegID reg, imm8 byte) : _reg(reg), _byte(byte)
     {}
 
-    void Sne_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Sne_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         if (cpu.getRegister(_reg) != _byte)
         {
@@ -181,7 +172,7 @@ namespace Instructions
         return stream << "sne " << _reg << ", " << std::hex << _byte;
     }
 
-    bool Sne_reg_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Sne_reg_imm::compile(JITSection &jit, addr12 pc) const
     {
         auto regAddr = getPtrForReg(_reg);
         auto targetLabel = jit.getLabelForAddress(pc + sizeof(opcode));
@@ -199,7 +190,7 @@ namespace Instructions
     Se_reg_reg::Se_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Se_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Se_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         if (cpu.getRegister(_reg1) == cpu.getRegister(_reg2))
         {
@@ -212,7 +203,7 @@ namespace Instructions
         return stream << "se " << _reg1 << ", " << _reg2;
     }
 
-    bool Se_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Se_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto regAddr1 = getPtrForReg(_reg1);
         auto regAddr2 = getPtrForReg(_reg2);
@@ -232,7 +223,7 @@ namespace Instructions
     Ld_reg_imm::Ld_reg_imm(RegID reg, imm8 byte) : _reg(reg), _byte(byte)
     {}
 
-    void Ld_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg) = _byte;
     }
@@ -242,7 +233,7 @@ namespace Instructions
         return stream << "ld " << _reg << ", " << std::hex << _byte;
     }
 
-    bool Ld_reg_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_reg_imm::compile(JITSection &jit, addr12 pc) const
     {
         jit.assm.mov(getPtrForReg(_reg), _byte);
 
@@ -252,7 +243,7 @@ namespace Instructions
     Add_reg_imm::Add_reg_imm(RegID reg, imm8 byte) : _reg(reg), _byte(byte)
     {}
 
-    void Add_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Add_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg) += _byte;
     }
@@ -262,7 +253,7 @@ namespace Instructions
         return stream << "add " << _reg << ", " << std::hex << _byte;
     }
 
-    bool Add_reg_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Add_reg_imm::compile(JITSection &jit, addr12 pc) const
     {
         jit.assm.add(getPtrForReg(_reg), _byte);
         return true;
@@ -271,7 +262,7 @@ namespace Instructions
     Ld_reg_reg::Ld_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Ld_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg1) = cpu.getRegister(_reg2);
     }
@@ -281,7 +272,7 @@ namespace Instructions
         return stream << "ld " << _reg1 << ", " << _reg2;
     }
 
-    bool Ld_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
         jit.assm.mov(getPtrForReg(_reg1), asmjit::x86::al);
@@ -291,7 +282,7 @@ namespace Instructions
     Or_reg_reg::Or_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Or_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Or_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg1) |= cpu.getRegister(_reg2);
     }
@@ -301,7 +292,7 @@ namespace Instructions
         return stream << "or " << _reg1 << ", " << _reg2;
     }
 
-    bool Or_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Or_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
         jit.assm.or_(getPtrForReg(_reg1), asmjit::x86::al);
@@ -311,7 +302,7 @@ namespace Instructions
     And_reg_reg::And_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void And_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void And_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg1) &= cpu.getRegister(_reg2);
     }
@@ -321,7 +312,7 @@ namespace Instructions
         return stream << "and " << _reg1 << ", " << _reg2;
     }
 
-    bool And_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool And_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
         jit.assm.and_(getPtrForReg(_reg1), asmjit::x86::al);
@@ -331,7 +322,7 @@ namespace Instructions
     Xor_reg_reg::Xor_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Xor_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Xor_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg1) ^= cpu.getRegister(_reg2);
     }
@@ -341,7 +332,7 @@ namespace Instructions
         return stream << "xor " << _reg1 << ", " << _reg2;
     }
 
-    bool Xor_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Xor_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
         jit.assm.xor_(getPtrForReg(_reg1), asmjit::x86::al);
@@ -351,13 +342,15 @@ namespace Instructions
     Add_reg_reg::Add_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Add_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Add_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
-        reg &reg1 = cpu.getRegister(_reg1);
-        reg &reg2 = cpu.getRegister(_reg2);
+        //Both operands are read before anything is written, and VF last, so the flag wins when reg1 is VF. compile()
+        //does the same, as do the other arithmetic instructions setting VF.
+        reg reg1 = cpu.getRegister(_reg1);
+        reg reg2 = cpu.getRegister(_reg2);
+        cpu.getRegister(_reg1) = reg1 + reg2;
         //Set VF to carry flag. I.e. if the result of the operation is larger than the highest representable value.
         cpu.getRegister(RegID::VF) = (reg1 + reg2) > MAX_REG;
-        reg1 += reg2;
     }
 
     std::ostream &Add_reg_reg::print(std::ostream &stream) const
@@ -365,10 +358,12 @@ namespace Instructions
         return stream << "add " << _reg1 << ", " << _reg2;
     }
 
-    bool Add_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Add_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
-        jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
-        jit.assm.add(getPtrForReg(_reg1), asmjit::x86::al);
+        //The result first and VF last, like in execute(). mov leaves the flags alone.
+        jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg1));
+        jit.assm.add(asmjit::x86::al, getPtrForReg(_reg2));
+        jit.assm.mov(getPtrForReg(_reg1), asmjit::x86::al);
         jit.assm.setc(getPtrForReg(RegID::VF));
         return true;
     }
@@ -376,13 +371,13 @@ namespace Instructions
     Sub_reg_reg::Sub_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Sub_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Sub_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
-        reg &reg1 = cpu.getRegister(_reg1);
-        reg &reg2 = cpu.getRegister(_reg2);
+        reg reg1 = cpu.getRegister(_reg1);
+        reg reg2 = cpu.getRegister(_reg2);
+        cpu.getRegister(_reg1) = reg1 - reg2;
         //Set VF to NOT borrow, i.e. if reg1 is larger than reg2.
         cpu.getRegister(RegID::VF) = reg1 > reg2;
-        reg1 -= reg2;
     }
 
     std::ostream &Sub_reg_reg::print(std::ostream &stream) const
@@ -390,24 +385,26 @@ namespace Instructions
         return stream << "sub " << _reg1 << ", " << _reg2;
     }
 
-    bool Sub_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Sub_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
-        jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
-        jit.assm.sub(getPtrForReg(_reg1), asmjit::x86::al);
-        jit.assm.setnc(getPtrForReg(RegID::VF));
+        //No borrow and not equal, i.e. reg1 is larger
+        jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg1));
+        jit.assm.sub(asmjit::x86::al, getPtrForReg(_reg2));
+        jit.assm.mov(getPtrForReg(_reg1), asmjit::x86::al);
+        jit.assm.seta(getPtrForReg(RegID::VF));
         return true;
     }
 
     Shr_reg::Shr_reg(RegID reg) : _reg(reg)
     {}
 
-    void Shr_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Shr_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
-        reg &reg = cpu.getRegister(_reg);
-        //set flag to least significant bit.
-        cpu.getRegister(RegID::VF) = reg & 1u;
-        //then divide
-        reg = reg >> 1u;
+        reg value = cpu.getRegister(_reg);
+        //divide
+        cpu.getRegister(_reg) = value >> 1u;
+        //then set flag to least significant bit.
+        cpu.getRegister(RegID::VF) = value & 1u;
     }
 
     std::ostream &Shr_reg::print(std::ostream &stream) const
@@ -415,9 +412,11 @@ namespace Instructions
         return stream << "shr " << _reg;
     }
 
-    bool Shr_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Shr_reg::compile(JITSection &jit, addr12 pc) const
     {
-        jit.assm.shr(getPtrForReg(_reg), 1);
+        jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg));
+        jit.assm.shr(asmjit::x86::al, 1);
+        jit.assm.mov(getPtrForReg(_reg), asmjit::x86::al);
         jit.assm.setc(getPtrForReg(RegID::VF));
 
         return true;
@@ -426,13 +425,13 @@ namespace Instructions
     Subn_reg_reg::Subn_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Subn_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Subn_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
-        reg &reg1 = cpu.getRegister(_reg1);
-        reg &reg2 = cpu.getRegister(_reg2);
-        //Set VF to NOT borrow, i.e. if reg1 is larger than reg2.
+        reg reg1 = cpu.getRegister(_reg1);
+        reg reg2 = cpu.getRegister(_reg2);
+        cpu.getRegister(_reg1) = reg2 - reg1;
+        //Set VF to NOT borrow, i.e. if reg2 is larger than reg1.
         cpu.getRegister(RegID::VF) = reg2 > reg1;
-        reg1 = reg2 - reg1;
     }
 
     std::ostream &Subn_reg_reg::print(std::ostream &stream) const
@@ -440,29 +439,29 @@ namespace Instructions
         return stream << "subn " << _reg1 << ", " << _reg2;
     }
 
-    bool Subn_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Subn_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         //al = reg2
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg2));
         //cl = reg1
         jit.assm.mov(asmjit::x86::cl, getPtrForReg(_reg1));
-        //al (reg2) = al (reg2) - cl(reg1)
-        jit.assm.sub(asmjit::x86::al, asmjit::x86::al);
-        jit.assm.setnc(getPtrForReg(RegID::VF));
+        //al (reg2) = al (reg2) - cl(reg1), VF set if reg2 is larger
+        jit.assm.sub(asmjit::x86::al, asmjit::x86::cl);
         jit.assm.mov(getPtrForReg(_reg1), asmjit::x86::al);
+        jit.assm.seta(getPtrForReg(RegID::VF));
         return true;
     }
 
     Shl_reg::Shl_reg(RegID reg) : _reg(reg)
     {}
 
-    void Shl_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Shl_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
-        reg &reg = cpu.getRegister(_reg);
-        //set flag to most significant bit.
-        cpu.getRegister(RegID::VF) = reg & MOST_SIGNIFICANT_BIT_MASK;
-        //then multiply
-        reg = reg << 1u;
+        reg value = cpu.getRegister(_reg);
+        //multiply
+        cpu.getRegister(_reg) = value << 1u;
+        //then set flag to the most significant bit, shifted out. 0 or 1 like every other flag.
+        cpu.getRegister(RegID::VF) = value >> 7u;
     }
 
     std::ostream &Shl_reg::print(std::ostream &stream) const
@@ -470,9 +469,12 @@ namespace Instructions
         return stream << "shl " << _reg;
     }
 
-    bool Shl_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Shl_reg::compile(JITSection &jit, addr12 pc) const
     {
-        jit.assm.shl(getPtrForReg(_reg), 1);
+        //The carry is the bit shifted out
+        jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg));
+        jit.assm.shl(asmjit::x86::al, 1);
+        jit.assm.mov(getPtrForReg(_reg), asmjit::x86::al);
         jit.assm.setc(getPtrForReg(RegID::VF));
 
         return true;
@@ -481,7 +483,7 @@ namespace Instructions
     Sne_reg_reg::Sne_reg_reg(RegID reg1, RegID reg2) : _reg1(reg1), _reg2(reg2)
     {}
 
-    void Sne_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Sne_reg_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         if (cpu.getRegister(_reg1) != cpu.getRegister(_reg2))
         {
@@ -494,7 +496,7 @@ namespace Instructions
         return stream << "sne " << _reg1 << ", " << _reg2;
     }
 
-    bool Sne_reg_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Sne_reg_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto targetLabel = jit.getLabelForAddress(pc + sizeof(opcode));
         if (targetLabel.has_value())
@@ -512,7 +514,7 @@ namespace Instructions
     Ld_I_imm::Ld_I_imm(addr12 addr) : _addr(addr)
     {}
 
-    void Ld_I_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_I_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.indexRegister = _addr;
     }
@@ -522,7 +524,7 @@ namespace Instructions
         return stream << "ld I, 0x" << std::hex << _addr;
     }
 
-    bool Ld_I_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_I_imm::compile(JITSection &jit, addr12 pc) const
     {
         auto indexAddr = asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister));
         jit.assm.mov(indexAddr, _addr);
@@ -530,20 +532,20 @@ namespace Instructions
         return true;
     }
 
-    Jp_v0_imm::Jp_v0_imm(addr12 target) : _target(target)
+    Jp_v0_imm::Jp_v0_imm(addr12 target) : target(target)
     {}
 
-    void Jp_v0_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Jp_v0_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
-        cpu.pc = static_cast<addr12>(_target + cpu.getRegister(RegID::V0)) & MEMORY_MASK;
+        cpu.pc = static_cast<addr12>(target + cpu.getRegister(RegID::V0)) & MEMORY_MASK;
     }
 
     std::ostream &Jp_v0_imm::print(std::ostream &stream) const
     {
-        return stream << "jp " << RegID::V0 << ", 0x" << std::hex << _target;
+        return stream << "jp " << RegID::V0 << ", 0x" << std::hex << target;
     }
 
-    bool Jp_v0_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Jp_v0_imm::compile(JITSection &jit, addr12 pc) const
     {
         return false;
     }
@@ -551,7 +553,7 @@ namespace Instructions
     Rnd_reg_imm::Rnd_reg_imm(RegID reg, imm8 byte) : _reg(reg), _byte(byte)
     {}
 
-    void Rnd_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Rnd_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg) = cpu.getRandom() & _byte;
     }
@@ -561,10 +563,26 @@ namespace Instructions
         return stream << "rnd " << _reg << ", " << std::hex << _byte;
     }
 
-    bool Rnd_reg_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Rnd_reg_imm::compile(JITSection &jit, addr12 pc) const
     {
-        jit.assm.mov(asmjit::x86::rax, reinterpret_cast<uint64_t>(&Cpu::getRandom));
-        jit.assm.call(asmjit::x86::rax);
+        //Cpu::getRandom, inline
+        auto rngState = asmjit::x86::dword_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, rngState));
+        jit.assm.mov(asmjit::x86::eax, rngState);
+
+        jit.assm.mov(asmjit::x86::ecx, asmjit::x86::eax);
+        jit.assm.shl(asmjit::x86::ecx, 13);
+        jit.assm.xor_(asmjit::x86::eax, asmjit::x86::ecx);
+
+        jit.assm.mov(asmjit::x86::ecx, asmjit::x86::eax);
+        jit.assm.shr(asmjit::x86::ecx, 17);
+        jit.assm.xor_(asmjit::x86::eax, asmjit::x86::ecx);
+
+        jit.assm.mov(asmjit::x86::ecx, asmjit::x86::eax);
+        jit.assm.shl(asmjit::x86::ecx, 5);
+        jit.assm.xor_(asmjit::x86::eax, asmjit::x86::ecx);
+
+        jit.assm.mov(rngState, asmjit::x86::eax);
+        jit.assm.shr(asmjit::x86::eax, 24);
 
         jit.assm.and_(asmjit::x86::al, _byte);
         jit.assm.mov(getPtrForReg(_reg), asmjit::x86::al);
@@ -576,7 +594,7 @@ namespace Instructions
                                                                                  _sprite_size(sprite_size)
     {}
 
-    void Drw_reg_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Drw_reg_reg_imm::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         auto &bitmap = io.getBitmap();
 
@@ -613,7 +631,7 @@ namespace Instructions
         return stream << "drw " << _regX << ", " << _regY << ", " << _sprite_size;
     }
 
-    bool Drw_reg_reg_imm::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Drw_reg_reg_imm::compile(JITSection &jit, addr12 pc) const
     {
         return false;
     }
@@ -621,7 +639,7 @@ namespace Instructions
     Skp_reg::Skp_reg(RegID reg) : _reg(reg)
     {}
 
-    void Skp_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Skp_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         if (io.isPressed(cpu.getRegister(_reg)))
         {
@@ -634,23 +652,18 @@ namespace Instructions
         return stream << "skp " << _reg;
     }
 
-    bool Skp_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Skp_reg::compile(JITSection &jit, addr12 pc) const
     {
         //TODO: Add IO call
         auto targetLabel = jit.getLabelForAddress(pc + sizeof(opcode));
         if (targetLabel.has_value())
         {
-            auto io_ptr = reinterpret_cast<uint64_t>(&io);
-            auto isPressed = &IO::isPressed;
-            uint64_t isPressedPtr = 0;
-            memcpy(&isPressedPtr, &isPressed, sizeof(isPressedPtr));
-
-            jit.assm.mov(asmjit::x86::rdi, io_ptr);
-            jit.assm.mov(asmjit::x86::rsi, getPtrForReg(_reg));
-            jit.assm.mov(asmjit::x86::rax, isPressedPtr);
-            jit.assm.call(asmjit::x86::rax);
+            jit.assm.mov(asmjit::x86::rdi, asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, io)));
+            jit.assm.movzx(asmjit::x86::esi, getPtrForReg(_reg));
+            jit.assm.call(asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, isPressed)));
 
-            jit.assm.test(asmjit::x86::rax, asmjit::x86::rax);
+            //Only al is defined for a bool return value
+            jit.assm.test(asmjit::x86::al, asmjit::x86::al);
             jit.assm.jnz(targetLabel.value());
 
             return true;
@@ -663,7 +676,7 @@ namespace Instructions
     Sknp_reg::Sknp_reg(RegID reg) : _reg(reg)
     {}
 
-    void Sknp_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Sknp_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         if (!io.isPressed(cpu.getRegister(_reg)))
         {
@@ -676,23 +689,18 @@ namespace Instructions
         return stream << "sknp " << _reg;
     }
 
-    bool Sknp_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Sknp_reg::compile(JITSection &jit, addr12 pc) const
     {
         //TODO: Add IO call
         auto targetLabel = jit.getLabelForAddress(pc + sizeof(opcode));
         if (targetLabel.has_value())
         {
-            auto io_ptr = reinterpret_cast<uint64_t>(&io);
-            auto isPressed = &IO::isPressed;
-            uint64_t isPressedPtr = 0;
-            memcpy(&isPressedPtr, &isPressed, sizeof(isPressedPtr));
+            jit.assm.mov(asmjit::x86::rdi, asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, io)));
+            jit.assm.movzx(asmjit::x86::esi, getPtrForReg(_reg));
+            jit.assm.call(asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, isPressed)));
 
-            jit.assm.mov(asmjit::x86::rdi, io_ptr);
-            jit.assm.mov(asmjit::x86::rsi, getPtrForReg(_reg));
-            jit.assm.mov(asmjit::x86::rax, isPressedPtr);
-            jit.assm.call(asmjit::x86::rax);
-
-            jit.assm.test(asmjit::x86::rax, asmjit::x86::rax);
+            //Only al is defined for a bool return value
+            jit.assm.test(asmjit::x86::al, asmjit::x86::al);
             jit.assm.jz(targetLabel.value());
 
             return true;
@@ -705,7 +713,7 @@ namespace Instructions
     Ld_reg_dt::Ld_reg_dt(RegID reg) : _reg(reg)
     {}
 
-    void Ld_reg_dt::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_reg_dt::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.getRegister(_reg) = cpu.delayTimer;
     }
@@ -715,7 +723,7 @@ namespace Instructions
         return stream << "ld " << _reg << ", DT";
     }
 
-    bool Ld_reg_dt::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_reg_dt::compile(JITSection &jit, addr12 pc) const
     {
         auto dtAddr = asmjit::x86::byte_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, delayTimer));
         jit.assm.mov(asmjit::x86::al, dtAddr);
@@ -726,7 +734,7 @@ namespace Instructions
     Ld_reg_K::Ld_reg_K(RegID reg) : _reg(reg)
     {}
 
-    void Ld_reg_K::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_reg_K::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         auto pressedKey = io.getPressedKey();
         if (pressedKey.has_value())
@@ -743,7 +751,7 @@ namespace Instructions
         return stream << "ld " << _reg << ", K";
     }
 
-    bool Ld_reg_K::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_reg_K::compile(JITSection &jit, addr12 pc) const
     {
         return false;
     }
@@ -751,7 +759,7 @@ namespace Instructions
     Ld_dt_reg::Ld_dt_reg(RegID reg) : _reg(reg)
     {}
 
-    void Ld_dt_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_dt_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.delayTimer = cpu.getRegister(_reg);
     }
@@ -761,7 +769,7 @@ namespace Instructions
         return stream << "ld DT, " << _reg;
     }
 
-    bool Ld_dt_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_dt_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto dtAddr = asmjit::x86::byte_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, delayTimer));
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg));
@@ -772,7 +780,7 @@ namespace Instructions
     Ld_st_reg::Ld_st_reg(RegID reg) : _reg(reg)
     {}
 
-    void Ld_st_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_st_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.soundTimer = cpu.getRegister(_reg);
     }
@@ -782,7 +790,7 @@ namespace Instructions
         return stream << "ld ST, " << _reg;
     }
 
-    bool Ld_st_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_st_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto stAddr = asmjit::x86::byte_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, soundTimer));
         jit.assm.mov(asmjit::x86::al, getPtrForReg(_reg));
@@ -793,7 +801,7 @@ namespace Instructions
     Add_I_reg::Add_I_reg(RegID reg) : _reg(reg)
     {}
 
-    void Add_I_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Add_I_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         cpu.indexRegister += cpu.getRegister(_reg);
     }
@@ -803,14 +811,13 @@ namespace Instructions
         return stream << "add I, " << _reg;
     }
 
-    bool Add_I_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Add_I_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto indexAddr = asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister));
 
+        //I wraps around at 16 bits like in execute(), not at the end of memory
         jit.assm.movzx(asmjit::x86::ax, getPtrForReg(_reg));
-        jit.assm.add(asmjit::x86::ax, indexAddr);
-        jit.assm.and_(asmjit::x86::ax, MEMORY_MASK);
-        jit.assm.mov(indexAddr, asmjit::x86::ax);
+        jit.assm.add(indexAddr, asmjit::x86::ax);
 
         return true;
     }
@@ -818,7 +825,7 @@ namespace Instructions
     Ld_F_reg::Ld_F_reg(RegID reg) : _reg(reg)
     {}
 
-    void Ld_F_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_F_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         //Every font character is composed of 5 bytes of memory.
         cpu.indexRegister = cpu.getRegister(_reg) * 5;
@@ -829,7 +836,7 @@ namespace Instructions
         return stream << "ld F, " << _reg;
     }
 
-    bool Ld_F_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_F_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto indexAddr = asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister));
 
@@ -842,7 +849,7 @@ namespace Instructions
     Ld_B_reg::Ld_B_reg(RegID reg) : _reg(reg)
     {}
 
-    void Ld_B_reg::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_B_reg::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         reg val = cpu.getRegister(_reg);
         for (unsigned int i = 0; i < 3; ++i)
@@ -859,7 +866,7 @@ namespace Instructions
         return stream << "ld B, " << _reg;
     }
 
-    bool Ld_B_reg::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_B_reg::compile(JITSection &jit, addr12 pc) const
     {
         auto indexAddr = asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister));
 
@@ -896,7 +903,8 @@ namespace Instructions
         jit.assm.shr(asmjit::x86::rdi, DIRTY_MAP_SHR);
 
         jit.assm.add(asmjit::x86::rdi, JIT_BASES::DIRTY_MAP_BASE);
-        jit.assm.mov(asmjit::x86::ecx, (3u >> DIRTY_MAP_SHR) + 1u);
+        //The digits may straddle two chunks
+        jit.assm.mov(asmjit::x86::ecx, (3u >> DIRTY_MAP_SHR) + 2u);
 
         jit.assm.cld();
         jit.assm.rep();
@@ -908,7 +916,7 @@ namespace Instructions
     Ld_I_regs::Ld_I_regs(RegID reg) : _reg(reg)
     {}
 
-    void Ld_I_regs::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_I_regs::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         for (unsigned int i = 0; i <= static_cast<imm4>(_reg); ++i)
         {
@@ -924,7 +932,7 @@ namespace Instructions
         return stream << "ld [I], " << _reg;
     }
 
-    bool Ld_I_regs::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_I_regs::compile(JITSection &jit, addr12 pc) const
     {
         auto indexAddr = asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister));
         unsigned int numToCopy = static_cast<imm4>(_reg) + 1u;
@@ -973,7 +981,8 @@ namespace Instructions
         jit.assm.shr(asmjit::x86::rdi, DIRTY_MAP_SHR);
 
         jit.assm.add(asmjit::x86::rdi, JIT_BASES::DIRTY_MAP_BASE);
-        jit.assm.mov(asmjit::x86::ecx, (numToCopy >> DIRTY_MAP_SHR) + 1u);
+        //I isn't known to be aligned, so the bytes may reach into one more chunk
+        jit.assm.mov(asmjit::x86::ecx, (numToCopy >> DIRTY_MAP_SHR) + 2u);
 
         jit.assm.cld();
         jit.assm.rep();
@@ -988,7 +997,7 @@ namespace Instructions
     Ld_regs_I::Ld_regs_I(RegID reg) : _reg(reg)
     {}
 
-    void Ld_regs_I::execute(Cpu &cpu, Memory &memory, IO &io)
+    void Ld_regs_I::execute(Cpu &cpu, Memory &memory, IO &io) const
     {
         for (int i = 0; i <= static_cast<imm4>(_reg); ++i)
         {
@@ -1003,7 +1012,7 @@ namespace Instructions
         return stream << "ld " << _reg << ", [I]";
     }
 
-    bool Ld_regs_I::compile(Memory &memory, IO &io, JITSection &jit, addr12 pc)
+    bool Ld_regs_I::compile(JITSection &jit, addr12 pc) const
     {
         auto indexAddr = asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister));
         unsigned int numToCopy = static_cast<imm4>(_reg) + 1u;
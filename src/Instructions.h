@@ -26,9 +26,9 @@ namespace Instructions
     public:
         explicit Invalid(word opcode);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -41,9 +41,9 @@ namespace Instructions
     public:
         explicit Sys(addr12 addr);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -56,9 +56,9 @@ namespace Instructions
     public:
         Cls() = default;
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -69,9 +69,9 @@ namespace Instructions
     public:
         Ret() = default;
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -82,9 +82,9 @@ namespace Instructions
     public:
         explicit Jp_imm(addr12 target);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
         addr12 target;
 
@@ -98,9 +98,9 @@ namespace Instructions
     public:
         explicit Call(addr12 target);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
         addr12 target;
 
@@ -113,9 +113,9 @@ namespace Instructions
     public:
         explicit Se_reg_imm(RegID reg, imm8 byte);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -129,9 +129,9 @@ namespace Instructions
     public:
         explicit Sne_reg_imm(RegID reg, imm8 byte);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -145,9 +145,9 @@ namespace Instructions
     public:
         explicit Se_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -161,9 +161,9 @@ namespace Instructions
     public:
         explicit Ld_reg_imm(RegID reg, imm8 byte);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -177,9 +177,9 @@ namespace Instructions
     public:
         explicit Add_reg_imm(RegID reg, imm8 byte);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -193,9 +193,9 @@ namespace Instructions
     public:
         explicit Ld_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -209,9 +209,9 @@ namespace Instructions
     public:
         explicit Or_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -225,9 +225,9 @@ namespace Instructions
     public:
         explicit And_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -241,9 +241,9 @@ namespace Instructions
     public:
         explicit Xor_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -257,9 +257,9 @@ namespace Instructions
     public:
         explicit Add_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -273,9 +273,9 @@ namespace Instructions
     public:
         explicit Sub_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -289,9 +289,9 @@ namespace Instructions
     public:
         explicit Shr_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -304,9 +304,9 @@ namespace Instructions
     public:
         explicit Subn_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -320,9 +320,9 @@ namespace Instructions
     public:
         explicit Shl_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -335,9 +335,9 @@ namespace Instructions
     public:
         explicit Sne_reg_reg(RegID reg1, RegID reg2);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -351,9 +351,9 @@ namespace Instructions
     public:
         explicit Ld_I_imm(addr12 addr);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -366,14 +366,14 @@ namespace Instructions
     public:
         explicit Jp_v0_imm(addr12 target);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
+
+        addr12 target;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
-
-        addr12 _target;
     };
 
     class Rnd_reg_imm final : public Instruction
@@ -381,9 +381,9 @@ namespace Instructions
     public:
         explicit Rnd_reg_imm(RegID reg, imm8 byte);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -397,9 +397,9 @@ namespace Instructions
     public:
         explicit Drw_reg_reg_imm(RegID reg1, RegID reg2, imm4 sprite_size);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -414,9 +414,9 @@ namespace Instructions
     public:
         explicit Skp_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -429,9 +429,9 @@ namespace Instructions
     public:
         explicit Sknp_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -444,9 +444,9 @@ namespace Instructions
     public:
         explicit Ld_reg_dt(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -459,9 +459,9 @@ namespace Instructions
     public:
         explicit Ld_reg_K(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -474,9 +474,9 @@ namespace Instructions
     public:
         explicit Ld_dt_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -489,9 +489,9 @@ namespace Instructions
     public:
         explicit Ld_st_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -504,9 +504,9 @@ namespace Instructions
     public:
         explicit Add_I_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -519,9 +519,9 @@ namespace Instructions
     public:
         explicit Ld_F_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -534,9 +534,9 @@ namespace Instructions
     public:
         explicit Ld_B_reg(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -549,9 +549,9 @@ namespace Instructions
     public:
         explicit Ld_I_regs(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
@@ -564,9 +564,9 @@ namespace Instructions
     public:
         explicit Ld_regs_I(RegID reg);
 
-        void execute(Cpu &cpu, Memory &memory, IO &io) override;
+        void execute(Cpu &cpu, Memory &memory, IO &io) const override;
 
-        bool compile(Memory &memory, IO &io, JITSection &jit, addr12 pc) override;
+        bool compile(JITSection &jit, addr12 pc) const override;
 
     private:
         std::ostream &print(std::ostream &stream) const override;
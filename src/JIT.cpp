@@ -1,23 +1,114 @@
 #include "JIT.h"
 
+static void clearScreen(IO *io)
+{
+    io->clear();
+    io->draw();
+}
+
+static bool isPressed(const IO *io, byte key)
+{
+    return io->isPressed(key);
+}
+
+JIT::JIT(Cpu &cpu, Memory &memory, IO &io, JITMode mode, CompilePool *pool, Coverage *coverage)
+        : _cpu(cpu), _memory(memory), _io(io),
+          _context{&cpu, memory.buf.data(), memory.dirtyMap.data(), &io, &clearScreen, &isPressed},
+          _mode(mode), _coverage(coverage), _pool(pool)
+{
+    if (_coverage != nullptr && _coverage->getMode() == CoverageMode::Exact)
+    {
+        _context.coverageHits = _coverage->getHitCounters();
+        _context.coverageFallThroughs = _coverage->getFallThroughCounters();
+    }
+
+    if (_mode == JITMode::Async && _pool == nullptr)
+    {
+        _ownPool = std::make_unique<CompilePool>(1);
+        _pool = _ownPool.get();
+    }
+
+    JITTelemetry::instance().add(this);
+}
+
+JITContext *JIT::getContext()
+{
+    return &_context;
+}
+
+JITStats JIT::getStats() const
+{
+    return JITStats{_sectionsCompiled, _cacheHits, _compileNanoseconds, _codeBytes};
+}
+
+uint64_t JIT::getInstructions() const
+{
+    return _context.instructions;
+}
+
+void JIT::setInstructionLimit(uint64_t limit)
+{
+    _context.instructionLimit = limit;
+}
 
-JIT::JIT(Cpu &cpu, Memory &memory, IO &io) : _cpu(cpu), _memory(memory), _io(io)
+std::map<word, SectionTelemetry> JIT::getTelemetry() const
 {
-    _jitWorker = std::thread(&JIT::_JITThreadLoop, this);
+    std::map<word, SectionTelemetry> sections;
+    for (size_t addr = 0; addr < MEMORY_SIZE; ++addr)
+    {
+        uint64_t calls = _invocations[addr].load(std::memory_order_relaxed);
+        if (calls != 0) sections[addr].invocations = calls;
+    }
+
+    std::lock_guard<std::mutex> lock(_mapMutex);
+    for (const auto &[addr, section] : _telemetry)
+    {
+        sections[addr].merge(section);
+    }
+
+    return sections;
+}
+
+void JIT::setBreakpoints(const std::bitset<MEMORY_SIZE> &breakpoints)
+{
+    if (breakpoints == _breakpoints) return;
+
+    //Queued jobs would compile for the old breakpoints
+    if (_pool != nullptr) _pool->cancel(this);
+
+    std::lock_guard<std::mutex> mapLock(_mapMutex);
+    for (auto &[addr, funcAndNumInsns] : _compiledCode)
+    {
+        JITCache::instance().release(funcAndNumInsns.first);
+    }
+    _compiledCode.clear();
+
+    //Back to the threshold, so the next call of every hot function compiles it again
+    for (auto &invocations : _hotInsns)
+    {
+        invocations = std::min(invocations, HOT_THRESHOLD);
+    }
+
+    _breakpoints = breakpoints;
 }
 
 JITFunction JIT::traceCall(word addr)
 {
+    if (_mode == JITMode::Disabled) return nullptr;
+
     auto invocations = _hotInsns.at(addr);
     JITFunction fptr = nullptr;
-    if (invocations >= 10)
+
+    auto &calls = _invocations[addr];
+    calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (invocations >= HOT_THRESHOLD)
     {
-        bool shouldCompile = invocations == 10;
+        bool shouldCompile = invocations == HOT_THRESHOLD;
 
         //Check if dirty
         {
             std::lock_guard<std::mutex> mapLock(_mapMutex);
-            auto funcAndNumInsns = _compiledCode[addr];
+            auto &funcAndNumInsns = _compiledCode[addr];
 
             fptr = funcAndNumInsns.first;
 
@@ -26,7 +117,11 @@ JITFunction JIT::traceCall(word addr)
             {
                 if (_memory.dirtyMap[i >> DIRTY_MAP_SHR])
                 {
-                    _jitrt.release(fptr);
+                    //Other instances might still be running this code, so only drop our reference to it
+                    JITCache::instance().release(fptr);
+                    funcAndNumInsns.first = nullptr;
+                    fptr = nullptr;
+                    _telemetry[addr].invalidations++;
 
                     //Clear all dirty bits
                     memset(&_memory.dirtyMap[i >> DIRTY_MAP_SHR], 0, funcAndNumInsns.second);
@@ -40,108 +135,371 @@ JITFunction JIT::traceCall(word addr)
         {
             _hotInsns.at(addr)++;
 
-            //work order is enqueued to JIT
+            auto queued = std::chrono::steady_clock::now();
+            if (_mode == JITMode::Sync)
             {
-                std::lock_guard<std::mutex> queueLock(_queueMutex);
-                _compilationQueue.push(addr);
+                _compileFunction(addr, queued);
+
+                std::lock_guard<std::mutex> mapLock(_mapMutex);
+                fptr = _compiledCode[addr].first;
+            } else
+            {
+                //work order is enqueued to JIT
+                _pool->submit(this, [this, addr, queued] { _compileFunction(addr, queued); });
             }
-            _queueCondVar.notify_one();
         }
     } else
     {
         _hotInsns.at(addr)++;
     }
 
+    if (fptr != nullptr && _coverage != nullptr && _coverage->getMode() == CoverageMode::Sections)
+    {
+        std::lock_guard<std::mutex> mapLock(_mapMutex);
+        _coverage->markSection(addr, _compiledInsns[addr]);
+    }
+
     return fptr;
 }
 
-JITFunction JIT::_compile(word addr, word numInsns)
+//Where the instruction at pc may transfer control to within the section, other than the next instruction
+static std::optional<word> branchTarget(const DecodedInstruction &insn, word pc)
 {
-    asmjit::CodeHolder code;
-    code.init(_jitrt.environment());
+    if (insn.op == Op::Jp_imm) return insn.nnn;
+    if (insn.isSkip()) return pc + 2 * sizeof(opcode);
+    return std::nullopt;
+}
+
+//Bytes at I the instruction accesses, if it's one that can be compiled
+static word accessSizeAtI(const DecodedInstruction &insn)
+{
+    switch (insn.op)
+    {
+        case Op::Ld_B_reg:
+            return 3;
+        case Op::Ld_I_regs:
+        case Op::Ld_regs_I:
+            return insn.x + 1;
+        default:
+            return 0;
+    }
+}
+
+//Marks the instructions that start a block: the entry, branch targets, whatever follows a branch, and the exits.
+//Blocks are only entered at their start and only left at their end, so they can be counted as a whole.
+static std::vector<bool> findBlockStarts(word addr, const std::vector<byte> &guest, const std::vector<word> &exits)
+{
+    std::vector<bool> starts(guest.size() / sizeof(opcode), false);
+    auto mark = [&](word target) {
+        if (target >= addr && target < addr + guest.size() && !((target - addr) & 1u))
+        {
+            starts[(target - addr) / sizeof(opcode)] = true;
+        }
+    };
+
+    mark(addr);
+    for (word exit : exits) mark(exit);
+
+    for (size_t offset = 0; offset < guest.size(); offset += sizeof(opcode))
+    {
+        word pc = addr + offset;
+        auto target = branchTarget(decode((guest[offset] << 8u) + guest[offset + 1]), pc);
+        if (target.has_value())
+        {
+            mark(*target);
+            mark(pc + sizeof(opcode));
+        }
+    }
+
+    return starts;
+}
+
+word JIT::emit(asmjit::CodeHolder &code, word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+               bool countCoverage)
+{
+    word numInsns = guest.size() / sizeof(opcode);
+
     JITSection jit(addr, numInsns, &code);
 
-    jit.assm.mov(JIT_BASES::CPU_BASE, &_cpu);
-    jit.assm.mov(JIT_BASES::MEMORY_BASE, _memory.buf.data());
-    jit.assm.mov(JIT_BASES::DIRTY_MAP_BASE, _memory.dirtyMap.data());
+    //The bases live in callee-saved registers so they survive calls to host helpers. The extra 8 bytes keep the
+    //stack 16-byte aligned for those calls.
+    jit.assm.push(JIT_BASES::CONTEXT_BASE);
+    jit.assm.push(JIT_BASES::DIRTY_MAP_BASE);
+    jit.assm.push(JIT_BASES::MEMORY_BASE);
+    jit.assm.push(JIT_BASES::CPU_BASE);
+    jit.assm.sub(asmjit::x86::rsp, 8);
+
+    jit.assm.mov(JIT_BASES::CONTEXT_BASE, asmjit::x86::rdi);
+    jit.assm.mov(JIT_BASES::CPU_BASE, asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, cpu)));
+    jit.assm.mov(JIT_BASES::MEMORY_BASE, asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, memory)));
+    jit.assm.mov(JIT_BASES::DIRTY_MAP_BASE,
+                 asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, dirtyMap)));
 
     word currentPC = addr;
 
+    std::vector<bool> blockStarts = findBlockStarts(addr, guest, exits);
+    //Instructions of the current block that were emitted but not counted yet
+    word uncounted = 0;
+
     word numCompiled = 0;
     for (; numCompiled < numInsns; ++numCompiled)
     {
+        if (blockStarts[numCompiled])
+        {
+            jit.countInstructions(uncounted);
+            uncounted = 0;
+        }
 
         //Bind label to current location - this is okay even in case of a vmexit since the instruction that triggered
         //the vmexit will be executed after ret.
         jit.assm.bind(jit.getLabelForAddress(currentPC).value());
-        auto insn = parseInstruction(_memory.getOpcode(currentPC));
+        size_t offset = numCompiled * sizeof(opcode);
+        auto opcodeAt = [&guest](size_t offset) { return static_cast<opcode>((guest[offset] << 8u) + guest[offset + 1]); };
+
+        //Jumps to the exit land on it as well, the label is bound before it
+        if (std::binary_search(exits.cbegin(), exits.cend(), currentPC))
+        {
+            jit.exitTo(currentPC);
+        }
+
+        //The timers only run between steps, so a delay loop would spin in here forever. The interpreter skips or
+        //sleeps through it instead.
+        if (offset + DELAY_LOOP_INSNS * sizeof(opcode) <= guest.size() &&
+            isDelayLoop(currentPC, opcodeAt(offset), opcodeAt(offset + 2), opcodeAt(offset + 4)))
+        {
+            auto expired = jit.assm.newLabel();
+            jit.assm.cmp(asmjit::x86::byte_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, delayTimer)), 0);
+            jit.assm.je(expired);
+            jit.exitTo(currentPC);
+            jit.assm.bind(expired);
+        }
+
+        //Accesses reaching past the end of memory throw in the interpreter, so they are left to it. Leaving in the
+        //middle of a block, what ran of it is counted first.
+        if (word size = accessSizeAtI(decode(opcodeAt(offset))))
+        {
+            jit.countInstructions(uncounted);
+            uncounted = 0;
+
+            auto inBounds = jit.assm.newLabel();
+            jit.assm.cmp(asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, indexRegister)), MEMORY_SIZE - size);
+            jit.assm.jbe(inBounds);
+            jit.exitTo(currentPC);
+            jit.assm.bind(inBounds);
+        }
+
+        //rax is free between instructions
+        if (countCoverage)
+        {
+            jit.assm.mov(asmjit::x86::rax,
+                         asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, coverageHits)));
+            jit.assm.add(asmjit::x86::qword_ptr(asmjit::x86::rax, currentPC * sizeof(uint64_t)), 1);
+        }
+
+        const Instruction &insn = parseInstruction(opcodeAt(offset));
+
+        //A branch ends its block, so the block is counted before it, the branch included. Branches out of the section
+        //don't compile, and aren't counted.
+        auto target = branchTarget(decode(opcodeAt(offset)), currentPC);
+        if (target.has_value() && !(*target & 1u) && jit.getLabelForAddress(*target).has_value())
+        {
+            jit.countInstructions(uncounted + 1);
+            uncounted = 0;
+
+            //Every loop has a jump back. Past the limit, it leaves the section as if it had been taken.
+            if (decode(opcodeAt(offset)).op == Op::Jp_imm && *target <= currentPC)
+            {
+                auto withinLimit = jit.assm.newLabel();
+                jit.assm.mov(asmjit::x86::rax,
+                             asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, instructions)));
+                jit.assm.cmp(asmjit::x86::rax,
+                             asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, instructionLimit)));
+                jit.assm.jb(withinLimit);
+                jit.exitTo(*target);
+                jit.assm.bind(withinLimit);
+            }
+        }
 
         currentPC += sizeof(opcode);
 
-        if (!insn->compile(_memory, _io, jit, currentPC))
+        if (!insn.compile(jit, currentPC))
         {
             //Reconcile PC before vmexit, we failed so we need to go one insn back
             currentPC -= sizeof(opcode);
+
+            //The interpreter counts it when it runs it, take back the hit counted above
+            if (countCoverage)
+            {
+                jit.assm.mov(asmjit::x86::rax,
+                             asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, coverageHits)));
+                jit.assm.sub(asmjit::x86::qword_ptr(asmjit::x86::rax, currentPC * sizeof(uint64_t)), 1);
+            }
             break;
         }
+
+        if (!target.has_value()) uncounted++;
+
+        //Code right after a skip only runs when it falls through, skipping jumps to the label of the instruction
+        //after next
+        if (countCoverage && decode(opcodeAt(offset)).isSkip())
+        {
+            word skipPC = currentPC - sizeof(opcode);
+            jit.assm.mov(asmjit::x86::rax,
+                         asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, coverageFallThroughs)));
+            jit.assm.add(asmjit::x86::qword_ptr(asmjit::x86::rax, skipPC * sizeof(uint64_t)), 1);
+        }
     }
 
+    jit.countInstructions(uncounted);
+
     //Set PC
     jit.assm.mov(asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, pc)), currentPC);
 
+    jit.assm.bind(jit.epilogue);
+    jit.assm.add(asmjit::x86::rsp, 8);
+    jit.assm.pop(JIT_BASES::CPU_BASE);
+    jit.assm.pop(JIT_BASES::MEMORY_BASE);
+    jit.assm.pop(JIT_BASES::DIRTY_MAP_BASE);
+    jit.assm.pop(JIT_BASES::CONTEXT_BASE);
     jit.assm.ret();
 
+    return numCompiled;
+}
+
+JITFunction JIT::_compile(word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                          SectionTelemetry &telemetry)
+{
+    bool countCoverage = _coverage != nullptr && _coverage->getMode() == CoverageMode::Exact;
+
+    JITFunction cached = JITCache::instance().acquire(addr, guest, exits, countCoverage);
+    if (cached != nullptr)
+    {
+        _cacheHits++;
+        telemetry.cacheHits = 1;
+        telemetry.insnsCompiled = JITCache::instance().getNumCompiled(cached);
+        return cached;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    asmjit::CodeHolder code;
+    code.init(JITCache::instance().environment());
+
+    word numCompiled = emit(code, addr, guest, exits, countCoverage);
+
+    telemetry.compiles = 1;
+    telemetry.insnsCompiled = numCompiled;
+    telemetry.insnsToRet = guest.size() / sizeof(opcode);
+    if (numCompiled < telemetry.insnsToRet)
+    {
+        size_t offset = numCompiled * sizeof(opcode);
+        telemetry.stoppedAt = decode((guest[offset] << 8u) + guest[offset + 1]).op;
+    }
+
     //Minimum number of instructions
-    if (numCompiled < 2) return nullptr;
+    JITFunction func = nullptr;
+    if (numCompiled >= MIN_SECTION_INSNS)
+    {
+        func = JITCache::instance().insert(addr, guest, exits, countCoverage, code, numCompiled);
+
+        _sectionsCompiled++;
+        _codeBytes += code.codeSize();
+        telemetry.codeBytes = code.codeSize();
+    }
+
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    _compileNanoseconds += nanoseconds;
+    telemetry.compileNanoseconds = nanoseconds;
 
-    JITFunction func;
-    asmjit::Error err = _jitrt.add(&func, &code);
-    if (err) throw std::runtime_error("asmjit::Error : " + std::to_string(err));
     return func;
 }
 
-void JIT::_JITThreadLoop()
+void JIT::precompile(const std::set<word> &addrs)
 {
-    while (!_exit)
-    {
-        word addr = 0;
-        {
-            std::unique_lock<std::mutex> lock(_queueMutex);
-            _queueCondVar.wait(lock, [&] { return !_compilationQueue.empty() || _exit; });
-            //Another _exit check
-            if (_exit) break;
+    if (_mode == JITMode::Disabled) return;
+
+    std::vector<word> work(addrs.cbegin(), addrs.cend());
+    std::atomic<size_t> nextIndex = 0;
+    auto queued = std::chrono::steady_clock::now();
 
-            addr = _compilationQueue.front();
-            _compilationQueue.pop();
+    auto worker = [&] {
+        for (size_t i = nextIndex++; i < work.size(); i = nextIndex++)
+        {
+            _compileFunction(work[i], queued);
         }
+    };
 
+    size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), work.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back(worker);
+    }
 
-        size_t numInsns = 0;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-        //Count until ret
-        for (int currAddr = addr;; currAddr += sizeof(word))
-        {
-            numInsns++;
-            auto insn = parseInstruction(_memory.getOpcode(currAddr));
-            if (dynamic_cast<Instructions::Ret *>(insn.get()) != nullptr) break;
-        }
+    //Past the threshold, so traceCall uses the sections right away instead of queueing them again
+    for (word addr : addrs)
+    {
+        _hotInsns.at(addr) = HOT_THRESHOLD + 1;
+    }
+}
 
-        JITFunction fptr = _compile(addr, numInsns);
+std::vector<byte> JIT::readFunction(const Memory &memory, word addr)
+{
+    size_t numInsns = 0;
 
-        {
-            std::lock_guard lock(_mapMutex);
-            _compiledCode[addr] = std::pair<JITFunction, short>(fptr, numInsns);
-        }
+    //Count until ret
+    for (int currAddr = addr; currAddr + sizeof(opcode) <= MEMORY_SIZE; currAddr += sizeof(word))
+    {
+        numInsns++;
+        if (decode(memory.getOpcode(currAddr)).op == Op::Ret) break;
     }
+
+    return std::vector<byte>(memory.buf.cbegin() + addr, memory.buf.cbegin() + addr + numInsns * sizeof(opcode));
 }
 
-JIT::~JIT()
+void JIT::_compileFunction(word addr, std::chrono::steady_clock::time_point queued)
 {
-    _exit = true;
+    //Take a copy of the code, the compiled section (and its cache key) are derived from this and nothing else
+    std::vector<byte> guest = readFunction(_memory, addr);
+    short numInsns = guest.size() / sizeof(opcode);
+
+    std::vector<word> exits;
+    for (word pc = addr; pc < addr + guest.size(); pc += sizeof(opcode))
+    {
+        if (_breakpoints[pc]) exits.push_back(pc);
+    }
 
-    _queueCondVar.notify_one();
+    SectionTelemetry telemetry;
+    JITFunction fptr = _compile(addr, guest, exits, telemetry);
 
-    //Wait until it exits
-    _jitWorker.join();
+    {
+        std::lock_guard lock(_mapMutex);
+        //Drop the reference to a previous version of this section, if it's still around
+        JITCache::instance().release(_compiledCode[addr].first);
+        _compiledCode[addr] = std::pair<JITFunction, short>(fptr, numInsns);
+        _compiledInsns[addr] = telemetry.insnsCompiled;
+
+        telemetry.queueNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - queued).count();
+        _telemetry[addr].merge(telemetry);
+    }
 }
 
+JIT::~JIT()
+{
+    //Nothing of ours may run after this point
+    if (_pool != nullptr) _pool->cancel(this);
+
+    JITTelemetry::instance().retire(this);
+
+    for (auto &[addr, funcAndNumInsns] : _compiledCode)
+    {
+        JITCache::instance().release(funcAndNumInsns.first);
+    }
+}
@@ -12,6 +12,14 @@
 #include <utility>
 #include <cstring>
 #include <condition_variable>
+#include <vector>
+#include <set>
+#include <map>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <bitset>
+#include <chrono>
 
 #include "constants.h"
 #include "types.h"
@@ -20,41 +28,127 @@
 
 #include "Instructions.h"
 #include "Parser.h"
+#include "JITContext.h"
+#include "JITCache.h"
+#include "ControlFlow.h"
+#include "CompilePool.h"
+#include "JITTelemetry.h"
+#include "Coverage.h"
+
+enum class JITMode : byte
+{
+    //Hot functions are compiled in the background and start running whenever they are ready
+    Async,
+    //Hot functions are compiled on the spot. Slower to warm up, but a run then depends on nothing but its input.
+    Sync,
+    //Everything is interpreted
+    Disabled,
+};
 
-typedef int (*JITFunction)(void);
+struct JITStats
+{
+    //Sections this instance emitted itself
+    uint64_t sectionsCompiled;
+    //Sections another instance had already compiled, see JITCache
+    uint64_t cacheHits;
+    //Spent emitting and publishing the sections this instance compiled
+    uint64_t compileNanoseconds;
+    //Host code of the sections this instance compiled
+    uint64_t codeBytes;
+};
 
 class JIT final
 {
 public:
-    JIT(Cpu &cpu, Memory &memory, IO &io);
+    //Async compiles on pool, which has to outlive the JIT. Without one, the JIT starts a compile thread of its own.
+    //Sections record what they run in coverage, if given, which has to outlive the JIT as well.
+    JIT(Cpu &cpu, Memory &memory, IO &io, JITMode mode = JITMode::Async, CompilePool *pool = nullptr,
+        Coverage *coverage = nullptr);
 
     ~JIT();
 
     JITFunction traceCall(word addr);
 
+    //Compiles the given functions ahead of time on all cores, blocking until they are done. The sections are
+    //validated against the dirty map like any other, so stale ones are simply compiled again.
+    void precompile(const std::set<word> &addrs);
+
+    //Compiled sections must be called with this
+    JITContext *getContext();
+
+    [[nodiscard]] JITStats getStats() const;
+
+    //Guest instructions executed by compiled sections
+    [[nodiscard]] uint64_t getInstructions() const;
+
+    //Once getInstructions() reaches the limit, compiled loops hand back to the interpreter on every jump back instead
+    //of spinning on in the section. There's no limit by default.
+    void setInstructionLimit(uint64_t limit);
+
+    //Everything recorded about each guest address called so far, see JITTelemetry for the whole process
+    [[nodiscard]] std::map<word, SectionTelemetry> getTelemetry() const;
+
+    //Makes compiled sections hand back to the interpreter right before executing any of these addresses. Changing
+    //them drops every section, they are compiled again on their next call.
+    void setBreakpoints(const std::bitset<MEMORY_SIZE> &breakpoints);
+
+    //Sections shorter than this aren't worth the call
+    static constexpr word MIN_SECTION_INSNS = 2;
+
+    //Returns the guest bytes of the function at addr, up to and including its ret. These are what a section is
+    //compiled from.
+    static std::vector<byte> readFunction(const Memory &memory, word addr);
+
+    //Emits the section for the function at addr and returns the number of instructions it covers. The section
+    //leaves to the interpreter before executing any of the addresses in exits, which must be sorted. With
+    //countCoverage, it counts every instruction and every skip that falls through in the JITContext's coverage
+    //counters. The code only depends on its arguments, so it can be compiled once and run by any instance.
+    static word emit(asmjit::CodeHolder &code, word addr, const std::vector<byte> &guest,
+                     const std::vector<word> &exits = {}, bool countCoverage = false);
+
 private:
-    asmjit::JitRuntime _jitrt;
+    //Number of calls before a function is queued for compilation
+    static constexpr byte HOT_THRESHOLD = 10;
 
     Memory &_memory;
     Cpu &_cpu;
     IO &_io;
 
-    bool _exit = false;
+    JITContext _context;
 
     std::array<byte, MEMORY_SIZE> _hotInsns = {};
 
-    std::mutex _queueMutex;
-    std::condition_variable _queueCondVar;
-    std::queue<word> _compilationQueue;
-
-    std::mutex _mapMutex;
+    mutable std::mutex _mapMutex;
     std::unordered_map<word, std::pair<JITFunction, short>> _compiledCode;
+    //Instructions the current section of each function covers, for Coverage::markSection()
+    std::unordered_map<word, word> _compiledInsns;
+
+    //Guarded by _mapMutex as well. Invocations are kept apart, they are counted on every call.
+    std::unordered_map<word, SectionTelemetry> _telemetry;
+    //Only written by traceCall, atomic so the telemetry can be read from anywhere
+    std::array<std::atomic<uint64_t>, MEMORY_SIZE> _invocations = {};
+
+    JITMode _mode;
+
+    Coverage *_coverage;
+
+    //Only changed while no compile job of ours is running
+    std::bitset<MEMORY_SIZE> _breakpoints;
+
+    //Written by the compile threads
+    std::atomic<uint64_t> _sectionsCompiled = 0;
+    std::atomic<uint64_t> _cacheHits = 0;
+    std::atomic<uint64_t> _compileNanoseconds = 0;
+    std::atomic<uint64_t> _codeBytes = 0;
 
-    std::thread _jitWorker;
+    std::unique_ptr<CompilePool> _ownPool;
+    CompilePool *_pool;
 
-    void _JITThreadLoop();
+    void _compileFunction(word addr, std::chrono::steady_clock::time_point queued);
 
-    JITFunction _compile(word addr, word numInsns);
+    //Fills in the compile fields of telemetry, and insnsCompiled for cache hits too
+    JITFunction _compile(word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                         SectionTelemetry &telemetry);
 };
 
 
@@ -0,0 +1,155 @@
+#include "JITCache.h"
+
+#include <cstdlib>
+#include <sstream>
+
+JITCache::JITCache()
+{
+    const char *perfMap = std::getenv("CHIP8_PERF_MAP");
+    const char *jitdumpDir = std::getenv("CHIP8_JITDUMP");
+
+    bool wantsMap = perfMap != nullptr && std::string(perfMap) != "0";
+    if (wantsMap || jitdumpDir != nullptr)
+    {
+        _perfMap = std::make_unique<PerfMap>(wantsMap, jitdumpDir != nullptr ? jitdumpDir : "");
+    }
+}
+
+JITCache &JITCache::instance()
+{
+    static JITCache cache;
+    return cache;
+}
+
+const asmjit::Environment &JITCache::environment() const
+{
+    return _jitrt.environment();
+}
+
+JITFunction JITCache::acquire(word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                              bool countsCoverage)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    JITFunction func = _find(_hash(addr, guest, exits, countsCoverage), addr, guest, exits, countsCoverage);
+    if (func != nullptr) _entries.at(func).refCount++;
+
+    return func;
+}
+
+JITFunction JITCache::insert(word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                             bool countsCoverage, asmjit::CodeHolder &code, word numCompiled)
+{
+    uint64_t hash = _hash(addr, guest, exits, countsCoverage);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //Someone else compiled the same code while we were busy, use theirs
+    JITFunction func = _find(hash, addr, guest, exits, countsCoverage);
+    if (func != nullptr)
+    {
+        _entries.at(func).refCount++;
+        return func;
+    }
+
+    asmjit::Error err = _jitrt.add(&func, &code);
+    if (err) throw std::runtime_error("asmjit::Error : " + std::to_string(err));
+
+    _byHash.emplace(hash, func);
+    _entries.emplace(func, Entry{hash, addr, guest, exits, countsCoverage, numCompiled, 1});
+
+    if (_perfMap)
+    {
+        std::ostringstream name;
+        name << "chip8_0x" << std::hex << addr << std::dec << "_" << guest.size() / sizeof(opcode) << "insns";
+        if (!exits.empty()) name << "_" << exits.size() << "exits";
+        if (countsCoverage) name << "_coverage";
+        _perfMap->add(reinterpret_cast<const void *>(func), code.codeSize(), name.str());
+    }
+
+    return func;
+}
+
+word JITCache::getNumCompiled(JITFunction func)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.at(func).numCompiled;
+}
+
+void JITCache::release(JITFunction func)
+{
+    if (func == nullptr) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto entry = _entries.find(func);
+    if (entry == _entries.end()) throw std::runtime_error("Released a section that isn't in the cache");
+
+    if (--entry->second.refCount != 0) return;
+
+    auto range = _byHash.equal_range(entry->second.hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == func)
+        {
+            _byHash.erase(it);
+            break;
+        }
+    }
+
+    _entries.erase(entry);
+    _jitrt.release(func);
+}
+
+void JITCache::preload(word addr, const std::vector<byte> &guest, const std::vector<byte> &code, word numCompiled)
+{
+    asmjit::CodeHolder holder;
+    holder.init(_jitrt.environment());
+
+    //The code is position independent, so it can be copied verbatim
+    asmjit::x86::Assembler assm(&holder);
+    assm.embed(code.data(), code.size());
+
+    //insert() hands out a reference, which is deliberately never given back
+    insert(addr, guest, {}, false, holder, numCompiled);
+}
+
+uint64_t JITCache::_hash(word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                         bool countsCoverage)
+{
+    //FNV-1a over the address, the guest bytes, the exits and the coverage flag
+    uint64_t hash = 0xcbf29ce484222325;
+    auto mix = [&hash](byte b) {
+        hash ^= b;
+        hash *= 0x100000001b3;
+    };
+
+    mix(addr & 0xffu);
+    mix(addr >> 8u);
+    for (byte b : guest) mix(b);
+    for (word exit : exits)
+    {
+        mix(exit & 0xffu);
+        mix(exit >> 8u);
+    }
+    mix(countsCoverage);
+
+    return hash;
+}
+
+JITFunction JITCache::_find(uint64_t hash, word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                            bool countsCoverage)
+{
+    auto range = _byHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const Entry &entry = _entries.at(it->second);
+        if (entry.addr == addr && entry.guest == guest && entry.exits == exits &&
+            entry.countsCoverage == countsCoverage)
+        {
+            return it->second;
+        }
+    }
+
+    return nullptr;
+}
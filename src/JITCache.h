@@ -0,0 +1,84 @@
+#pragma once
+
+#include "asmjit/asmjit.h"
+#include "JITContext.h"
+#include "PerfMap.h"
+#include "types.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef int (*JITFunction)(JITContext *context);
+
+//Process-wide store of compiled sections. Sections only reach their instance through the JITContext argument, so the
+//code depends on nothing but the guest bytes it was compiled from and the address they live at. Every CHIP8 running
+//the same function shares a single copy of it.
+//
+//Set CHIP8_PERF_MAP=1 in the environment to have every section listed in /tmp/perf-<pid>.map, and
+//CHIP8_JITDUMP=<dir> to have a jitdump written there as well, see PerfMap. Sections are named after their guest
+//address and length.
+class JITCache final
+{
+public:
+    static JITCache &instance();
+
+    JITCache(const JITCache &) = delete;
+
+    JITCache &operator=(const JITCache &) = delete;
+
+    [[nodiscard]] const asmjit::Environment &environment() const;
+
+    //Returns the section compiled from `guest` at `addr` with the given exits and coverage counting (see JIT::emit),
+    //or nullptr if nobody compiled it yet. Every non-null result must be given back with release().
+    JITFunction acquire(word addr, const std::vector<byte> &guest, const std::vector<word> &exits = {},
+                        bool countsCoverage = false);
+
+    //Publishes freshly emitted code, which covers the first numCompiled instructions of guest. If another instance
+    //beat us to it, their copy is returned and ours is dropped. Like acquire(), the result must be given back with
+    //release().
+    JITFunction insert(word addr, const std::vector<byte> &guest, const std::vector<word> &exits, bool countsCoverage,
+                       asmjit::CodeHolder &code, word numCompiled);
+
+    //Number of instructions of its guest code the section covers, as given to insert()
+    [[nodiscard]] word getNumCompiled(JITFunction func);
+
+    void release(JITFunction func);
+
+    //Loads code that was emitted and flattened ahead of time (see the static recompiler). Preloaded sections are owned
+    //by the cache and live for the rest of the process.
+    void preload(word addr, const std::vector<byte> &guest, const std::vector<byte> &code, word numCompiled);
+
+private:
+    JITCache();
+
+    struct Entry
+    {
+        uint64_t hash;
+        word addr;
+        std::vector<byte> guest;
+        std::vector<word> exits;
+        bool countsCoverage;
+        word numCompiled;
+        size_t refCount;
+    };
+
+    static uint64_t _hash(word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                          bool countsCoverage);
+
+    JITFunction _find(uint64_t hash, word addr, const std::vector<byte> &guest, const std::vector<word> &exits,
+                      bool countsCoverage);
+
+    asmjit::JitRuntime _jitrt;
+
+    std::mutex _mutex;
+    std::unordered_multimap<uint64_t, JITFunction> _byHash;
+    std::unordered_map<JITFunction, Entry> _entries;
+
+    //Null unless perf output was asked for
+    std::unique_ptr<PerfMap> _perfMap;
+};
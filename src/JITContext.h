@@ -0,0 +1,33 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+
+class Cpu;
+
+class IO;
+
+//Everything a compiled section needs to know about the instance it runs on. Sections get a pointer to this as their
+//only argument and load their base registers from it, so the emitted code doesn't contain any instance addresses.
+struct JITContext
+{
+    Cpu *cpu;
+    byte *memory;
+    byte *dirtyMap;
+    IO *io;
+
+    //Host helpers are called through the context as well, to keep absolute addresses out of the emitted code.
+    void (*clearScreen)(IO *io);
+    bool (*isPressed)(const IO *io, byte key);
+
+    //Guest instructions executed by compiled sections, counted a block at a time
+    uint64_t instructions = 0;
+
+    //Sections leave at their next jump back once instructions reaches this, see JIT::setInstructionLimit()
+    uint64_t instructionLimit = UINT64_MAX;
+
+    //Coverage::getHitCounters() and getFallThroughCounters(), for sections compiled to count coverage
+    uint64_t *coverageHits = nullptr;
+    uint64_t *coverageFallThroughs = nullptr;
+};
@@ -1,4 +1,7 @@
 #include "JITSection.h"
+#include "Instruction.h"
+#include "Cpu.h"
+#include "JITContext.h"
 
 JITSection::JITSection(word startingAddr, word numInsns, asmjit::CodeHolder *code, bool shouldLog)
         : _startingAddr(startingAddr), _numInsns(numInsns), _logger(stdout), assm(code)
@@ -7,6 +10,7 @@ JITSection::JITSection(word startingAddr, word numInsns, asmjit::CodeHolder *cod
     {
         _labels.push_back(assm.newLabel());
     }
+    epilogue = assm.newLabel();
 
     if (shouldLog)
     {
@@ -19,4 +23,17 @@ std::optional<asmjit::Label> JITSection::getLabelForAddress(word addr)
     if (addr & 1u) throw std::runtime_error("Odd address");
     if ((addr < _startingAddr) || (addr >= (_startingAddr + _numInsns * sizeof(opcode)))) return std::nullopt;
     return _labels.at((addr - _startingAddr) / 2);
-}
\ No newline at end of file
+}
+
+void JITSection::exitTo(word pc)
+{
+    assm.mov(asmjit::x86::word_ptr(JIT_BASES::CPU_BASE, offsetof(Cpu, pc)), pc);
+    assm.jmp(epilogue);
+}
+
+void JITSection::countInstructions(word count)
+{
+    if (count == 0) return;
+
+    assm.add(asmjit::x86::qword_ptr(JIT_BASES::CONTEXT_BASE, offsetof(JITContext, instructions)), count);
+}
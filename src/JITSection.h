@@ -18,8 +18,17 @@ public:
 
     std::optional<asmjit::Label> getLabelForAddress(word addr);
 
+    //Leaves the section, the interpreter carries on at pc
+    void exitTo(word pc);
+
+    //Adds to JITContext::instructions
+    void countInstructions(word count);
+
     asmjit::x86::Assembler assm;
 
+    //Bound where the section restores the host registers and returns
+    asmjit::Label epilogue;
+
 private:
     std::vector<asmjit::Label> _labels;
 
@@ -0,0 +1,155 @@
+#include "JITTelemetry.h"
+#include "JIT.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <unistd.h>
+
+//Written by the signal handler, read by the dump thread
+static int dumpPipe = -1;
+
+static void requestDump(int)
+{
+    char request = 'd';
+    [[maybe_unused]] ssize_t written = write(dumpPipe, &request, 1);
+}
+
+void SectionTelemetry::merge(const SectionTelemetry &other)
+{
+    invocations += other.invocations;
+    compiles += other.compiles;
+    cacheHits += other.cacheHits;
+    invalidations += other.invalidations;
+    compileNanoseconds += other.compileNanoseconds;
+    queueNanoseconds += other.queueNanoseconds;
+
+    if (other.compiles != 0)
+    {
+        codeBytes = other.codeBytes;
+        insnsCompiled = other.insnsCompiled;
+        insnsToRet = other.insnsToRet;
+        stoppedAt = other.stoppedAt;
+    }
+}
+
+JITTelemetry &JITTelemetry::instance()
+{
+    static JITTelemetry telemetry;
+    return telemetry;
+}
+
+JITTelemetry::JITTelemetry()
+{
+    const char *path = std::getenv("CHIP8_JIT_TELEMETRY");
+    if (path == nullptr || *path == '\0') return;
+
+    _path = path;
+
+    if (pipe(_pipe) != 0) throw std::runtime_error("Failed to create the telemetry pipe");
+    dumpPipe = _pipe[1];
+
+    _dumpThread = std::thread(&JITTelemetry::_dumpLoop, this);
+
+    struct sigaction act = {};
+    act.sa_handler = &requestDump;
+    act.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &act, nullptr);
+}
+
+JITTelemetry::~JITTelemetry()
+{
+    if (_path.empty()) return;
+
+    //Anything but 'd' stops the thread
+    char request = 'q';
+    [[maybe_unused]] ssize_t written = write(_pipe[1], &request, 1);
+    _dumpThread.join();
+
+    _dump();
+}
+
+void JITTelemetry::add(const JIT *jit)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _live.insert(jit);
+}
+
+void JITTelemetry::retire(const JIT *jit)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (const auto &[addr, section] : jit->getTelemetry())
+    {
+        _retired[addr].merge(section);
+    }
+    _live.erase(jit);
+}
+
+std::map<word, SectionTelemetry> JITTelemetry::collect()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::map<word, SectionTelemetry> sections = _retired;
+    for (const JIT *jit : _live)
+    {
+        for (const auto &[addr, section] : jit->getTelemetry())
+        {
+            sections[addr].merge(section);
+        }
+    }
+
+    return sections;
+}
+
+void JITTelemetry::writeJSON(std::ostream &stream)
+{
+    stream << "{\"sections\": [";
+
+    bool first = true;
+    for (const auto &[addr, section] : collect())
+    {
+        stream << (first ? "" : ",") << "\n  {\"addr\": \"0x" << std::hex << std::setw(3) << std::setfill('0') << addr
+               << std::dec << "\", \"invocations\": " << section.invocations
+               << ", \"compiles\": " << section.compiles
+               << ", \"cache_hits\": " << section.cacheHits
+               << ", \"invalidations\": " << section.invalidations
+               << ", \"compile_ns\": " << section.compileNanoseconds
+               << ", \"queue_ns\": " << section.queueNanoseconds
+               << ", \"code_bytes\": " << section.codeBytes
+               << ", \"insns_compiled\": " << section.insnsCompiled
+               << ", \"insns_to_ret\": " << section.insnsToRet
+               << ", \"stopped_at\": ";
+
+        if (section.stoppedAt) stream << "\"" << opName(*section.stoppedAt) << "\"";
+        else stream << "null";
+
+        stream << "}";
+        first = false;
+    }
+
+    stream << "\n]}\n";
+}
+
+void JITTelemetry::_dumpLoop()
+{
+    char request;
+    while (read(_pipe[0], &request, 1) == 1 && request == 'd')
+    {
+        _dump();
+    }
+}
+
+void JITTelemetry::_dump()
+{
+    //Written next to the destination and renamed over it, so readers never see half a dump
+    std::string temp = _path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        if (!out.is_open()) return;
+        writeJSON(out);
+    }
+
+    std::rename(temp.c_str(), _path.c_str());
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DecodeTable.h"
+#include "types.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <thread>
+
+class JIT;
+
+//What the JIT did with the function at one guest address
+struct SectionTelemetry
+{
+    //Calls seen by traceCall, compiled or not
+    uint64_t invocations = 0;
+    //Sections this instance emitted itself, and ones it found compiled already in the JITCache
+    uint64_t compiles = 0;
+    uint64_t cacheHits = 0;
+    //Compiled sections dropped because the dirty map said their code changed
+    uint64_t invalidations = 0;
+
+    //Spent emitting and publishing, over all compiles
+    uint64_t compileNanoseconds = 0;
+    //From queueing the compile until the section was published, over all compiles and cache hits
+    uint64_t queueNanoseconds = 0;
+
+    //The rest is about the latest section emitted
+    uint64_t codeBytes = 0;
+    word insnsCompiled = 0;
+    //Up to and including the ret, which is as far as a section could go
+    word insnsToRet = 0;
+    //The instruction whose compile() returned false, where the section hands back to the interpreter. A ret there is
+    //the normal end of a section.
+    std::optional<Op> stoppedAt;
+
+    //Sums the counters, and takes the latest section of the two
+    void merge(const SectionTelemetry &other);
+};
+
+//Collects the telemetry of every JIT in the process, summed per guest address, and writes it out as JSON.
+//
+//Set CHIP8_JIT_TELEMETRY=<path> in the environment to have it written there at exit, and again every time the
+//process gets a SIGUSR1.
+class JITTelemetry final
+{
+public:
+    static JITTelemetry &instance();
+
+    JITTelemetry(const JITTelemetry &) = delete;
+
+    JITTelemetry &operator=(const JITTelemetry &) = delete;
+
+    ~JITTelemetry();
+
+    void add(const JIT *jit);
+
+    //Keeps what the JIT collected once it's gone
+    void retire(const JIT *jit);
+
+    [[nodiscard]] std::map<word, SectionTelemetry> collect();
+
+    void writeJSON(std::ostream &stream);
+
+private:
+    JITTelemetry();
+
+    void _dumpLoop();
+
+    void _dump();
+
+    std::mutex _mutex;
+    std::set<const JIT *> _live;
+    std::map<word, SectionTelemetry> _retired;
+
+    //Empty unless dumping was asked for
+    std::string _path;
+
+    //The signal handler wakes the dump thread through this pipe, the only thing it may safely do
+    int _pipe[2] = {-1, -1};
+    std::thread _dumpThread;
+};
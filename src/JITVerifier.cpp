@@ -0,0 +1,140 @@
+#include "JITVerifier.h"
+#include "Parser.h"
+
+#include <iomanip>
+#include <sstream>
+
+void JITVerifier::before(const Cpu &cpu, const Memory &memory, IO &io)
+{
+    _entry = cpu.pc;
+    _cpu = cpu;
+    _memory = memory;
+    _io.getBitmap() = io.getBitmap();
+    _io.getKeys() = io.getKeys();
+}
+
+void JITVerifier::after(uint64_t instructions, const Cpu &cpu, const Memory &memory, IO &io)
+{
+    _executed.clear();
+
+    //Exactly like CHIP8::_step, minus the timers and input, which don't run inside a section
+    for (uint64_t i = 0; i < instructions; ++i)
+    {
+        word pc = _cpu.pc;
+        try
+        {
+            if (pc & 1u) throw std::runtime_error("Odd address executed");
+
+            ::opcode opcode = _memory.getOpcode(pc);
+            _executed.push_back(Executed{pc, opcode});
+
+            _cpu.pc = _cpu.pc + sizeof(opcode);
+            parseInstruction(opcode).execute(_cpu, _memory, _io);
+        } catch (const std::exception &e)
+        {
+            std::ostringstream differences;
+            differences << "  the interpreter failed at 0x" << std::hex << pc << " (" << e.what()
+                        << ") where the section carried on\n";
+            throw JITDivergence(_describe(i + 1, differences.str()));
+        }
+    }
+
+    std::string differences = _compare(cpu, memory, io);
+    if (!differences.empty()) throw JITDivergence(_describe(instructions, differences));
+
+    _sectionsVerified++;
+}
+
+uint64_t JITVerifier::getSectionsVerified() const
+{
+    return _sectionsVerified;
+}
+
+std::string JITVerifier::_compare(const Cpu &cpu, const Memory &memory, IO &io)
+{
+    std::ostringstream differences;
+    differences << std::hex;
+
+    auto compare = [&](const std::string &name, unsigned int compiled, unsigned int interpreted) {
+        if (compiled != interpreted)
+        {
+            differences << "  " << name << ": compiled 0x" << compiled << ", interpreted 0x" << interpreted << "\n";
+        }
+    };
+
+    for (unsigned int i = 0; i < 16; ++i)
+    {
+        std::ostringstream name;
+        name << static_cast<RegID>(i);
+        compare(name.str(), cpu.registers[i], _cpu.registers[i]);
+    }
+    compare("I", cpu.indexRegister, _cpu.indexRegister);
+    compare("pc", cpu.pc, _cpu.pc);
+    compare("sp", cpu.sp, _cpu.sp);
+    compare("dt", cpu.delayTimer, _cpu.delayTimer);
+    compare("st", cpu.soundTimer, _cpu.soundTimer);
+    compare("rnd state", cpu.rngState, _cpu.rngState);
+
+    size_t differentBytes = 0;
+    for (size_t addr = 0; addr < MEMORY_SIZE; ++addr)
+    {
+        if (memory.buf[addr] == _memory.buf[addr]) continue;
+
+        if (differentBytes++ < LISTED_BYTES)
+        {
+            std::ostringstream name;
+            name << "[0x" << std::hex << addr << "]";
+            compare(name.str(), memory.buf[addr], _memory.buf[addr]);
+        }
+    }
+    if (differentBytes > LISTED_BYTES)
+    {
+        differences << "  " << std::dec << differentBytes - LISTED_BYTES << " more bytes differ\n" << std::hex;
+    }
+
+    //Sections may mark more than they wrote, that only costs a recompile
+    for (size_t chunk = 0; chunk < _memory.dirtyMap.size(); ++chunk)
+    {
+        if (_memory.dirtyMap[chunk] && !memory.dirtyMap[chunk])
+        {
+            differences << "  [0x" << (chunk << DIRTY_MAP_SHR) << "] written but not marked dirty\n";
+        }
+    }
+
+    const auto &bitmap = io.getBitmap();
+    size_t differentPixels = 0;
+    size_t firstPixel = 0;
+    for (size_t pixel = 0; pixel < NUM_PIXELS; ++pixel)
+    {
+        if (bitmap[pixel] == _io.getBitmap()[pixel]) continue;
+
+        if (differentPixels++ == 0) firstPixel = pixel;
+    }
+    if (differentPixels != 0)
+    {
+        differences << "  framebuffer: " << std::dec << differentPixels << " pixels differ, the first at ("
+                    << firstPixel % PIXEL_WIDTH << ", " << firstPixel / PIXEL_WIDTH << ")\n" << std::hex;
+    }
+
+    return differences.str();
+}
+
+std::string JITVerifier::_describe(uint64_t instructions, const std::string &differences) const
+{
+    std::ostringstream description;
+    description << "Section at 0x" << std::hex << _entry << " diverged from the interpreter after " << std::dec
+                << instructions << " instructions:\n" << differences;
+
+    size_t first = _executed.size() > LISTED_INSTRUCTIONS ? _executed.size() - LISTED_INSTRUCTIONS : 0;
+    description << "Interpreted";
+    if (first != 0) description << " (the last " << LISTED_INSTRUCTIONS << ")";
+    description << ":\n";
+
+    for (size_t i = first; i < _executed.size(); ++i)
+    {
+        description << "  0x" << std::hex << std::setw(3) << std::setfill('0') << _executed[i].pc << ": "
+                    << parseInstruction(_executed[i].opcode) << "\n";
+    }
+
+    return description.str();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Cpu.h"
+#include "Memory.h"
+#include "IO.h"
+#include "NullBackend.h"
+#include "types.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//A compiled section left the machine in a different state than the interpreter would have
+class JITDivergence final : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+//Checks compiled sections against the interpreter, see CHIP8Options::verifyJIT. Before every section it copies the
+//machine, and after it runs the interpreter over the copy for as many instructions as the section executed, then
+//compares the two: registers, I, pc, sp, timers, rnd state, memory and the framebuffer. Writes the interpreter marked
+//dirty have to be marked by the section too, or stale sections would keep running.
+class JITVerifier final
+{
+public:
+    //Copies the machine right before a section is called
+    void before(const Cpu &cpu, const Memory &memory, IO &io);
+
+    //Interprets the instructions the section executed on the copy, and throws a JITDivergence describing every
+    //difference, along with the instructions, if the two don't end up the same
+    void after(uint64_t instructions, const Cpu &cpu, const Memory &memory, IO &io);
+
+    //Number of sections checked so far
+    [[nodiscard]] uint64_t getSectionsVerified() const;
+
+private:
+    //Where an interpreted instruction was, and what it was
+    struct Executed
+    {
+        word pc;
+        ::opcode opcode;
+    };
+
+    //Interpreted instructions listed when a section diverges, the latest ones
+    static constexpr size_t LISTED_INSTRUCTIONS = 32;
+
+    //Memory differences listed, the rest are only counted
+    static constexpr size_t LISTED_BYTES = 16;
+
+    [[nodiscard]] std::string _compare(const Cpu &cpu, const Memory &memory, IO &io);
+
+    [[nodiscard]] std::string _describe(uint64_t instructions, const std::string &differences) const;
+
+    //Where the section was called
+    word _entry = 0;
+
+    Cpu _cpu;
+    Memory _memory;
+    NullBackend _backend;
+    IO _io{_backend};
+
+    std::vector<Executed> _executed;
+
+    uint64_t _sectionsVerified = 0;
+};
@@ -0,0 +1,94 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    uint64_t value = duration.count() > 0 ? duration.count() : 0;
+
+    _counts[_bucketOf(value)]++;
+    _count++;
+    _sum += value;
+    if (value > _max) _max = value;
+}
+
+size_t LatencyHistogram::_bucketOf(uint64_t value)
+{
+    if (value < 2 * SUB_BUCKETS) return value;
+
+    //The top SUB_BUCKET_BITS + 1 bits of the value, the first of which is always set
+    unsigned int shift = std::bit_width(value) - SUB_BUCKET_BITS - 1;
+    return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::_bucketEnd(size_t bucket)
+{
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+
+    unsigned int shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+    uint64_t top = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+    return ((top + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return _count;
+}
+
+std::chrono::nanoseconds LatencyHistogram::getPercentile(double percent) const
+{
+    if (_count == 0) return std::chrono::nanoseconds(0);
+
+    auto rank = static_cast<uint64_t>(std::ceil(percent / 100 * _count));
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    {
+        seen += _counts[bucket];
+        if (seen >= rank) return std::chrono::nanoseconds(std::min(_bucketEnd(bucket), _max));
+    }
+
+    return getMax();
+}
+
+std::chrono::nanoseconds LatencyHistogram::getMax() const
+{
+    return std::chrono::nanoseconds(_max);
+}
+
+std::chrono::nanoseconds LatencyHistogram::getMean() const
+{
+    return std::chrono::nanoseconds(_count == 0 ? 0 : _sum / _count);
+}
+
+void RunLoopStats::print(std::ostream &stream) const
+{
+    const std::pair<const char *, const LatencyHistogram *> histograms[] = {
+            {"cycle",  &cycle},
+            {"frame",  &frame},
+            {"draw",   &draw},
+            {"poll",   &poll},
+            {"jit",    &jit},
+            {"sleep+", &sleepOvershoot},
+    };
+
+    auto us = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+
+    stream << "run loop (us)\tcount\tmean\tp50\tp90\tp99\tp99.9\tmax\n" << std::fixed << std::setprecision(1);
+    for (const auto &[name, histogram] : histograms)
+    {
+        stream << name << "\t" << histogram->getCount() << "\t" << us(histogram->getMean());
+        for (double percent : {50.0, 90.0, 99.0, 99.9})
+        {
+            stream << "\t" << us(histogram->getPercentile(percent));
+        }
+        stream << "\t" << us(histogram->getMax()) << "\n";
+    }
+
+    stream << "missed frames: " << missedFrames << " ("
+           << (frame.getCount() ? 100.0 * missedFrames / frame.getCount() : 0.0) << "%)" << std::endl;
+}
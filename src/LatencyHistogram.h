@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+//Histogram of durations, log-linear like HdrHistogram: every power of two is split into SUB_BUCKETS linear buckets, so
+//any value is kept to within 1/SUB_BUCKETS of itself from a nanosecond up to centuries, in a fixed array. Recording is
+//a few instructions and never allocates.
+class LatencyHistogram final
+{
+public:
+    static constexpr unsigned int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+
+    void record(std::chrono::nanoseconds duration);
+
+    [[nodiscard]] uint64_t getCount() const;
+
+    //The smallest duration at least the given percentage of the recorded ones are at or under, rounded up to the end
+    //of its bucket. 0 if nothing was recorded.
+    [[nodiscard]] std::chrono::nanoseconds getPercentile(double percent) const;
+
+    //Exact
+    [[nodiscard]] std::chrono::nanoseconds getMax() const;
+
+    [[nodiscard]] std::chrono::nanoseconds getMean() const;
+
+private:
+    //Values under 2 * SUB_BUCKETS have a bucket each, every power of two above has SUB_BUCKETS
+    static constexpr size_t NUM_BUCKETS = 2 * SUB_BUCKETS + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    static size_t _bucketOf(uint64_t value);
+
+    //Largest value that falls in the bucket
+    static uint64_t _bucketEnd(size_t bucket);
+
+    std::array<uint64_t, NUM_BUCKETS> _counts = {};
+    uint64_t _count = 0;
+    uint64_t _max = 0;
+    //Wraps after 584 years of recorded time
+    uint64_t _sum = 0;
+};
+
+//How well CHIP8::run() keeps time, see CHIP8::getRunLoopStats()
+struct RunLoopStats
+{
+    //Host time per guest cycle, not counting sleeps. Skipped idle loops count as their number of cycles.
+    LatencyHistogram cycle;
+    //Wall time between timer ticks, which should be 1/60s
+    LatencyHistogram frame;
+    //IO::draw(), mostly the backend presenting the frame
+    LatencyHistogram draw;
+    //IO::pollEvents()
+    LatencyHistogram poll;
+    //Every run of a compiled section
+    LatencyHistogram jit;
+    //How much longer sleeps took than asked for
+    LatencyHistogram sleepOvershoot;
+
+    //Frames that took long enough to miss a refresh of a 60Hz display
+    uint64_t missedFrames = 0;
+
+    //A table of percentiles per histogram, and the missed frames
+    void print(std::ostream &stream) const;
+};
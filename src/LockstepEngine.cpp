@@ -0,0 +1,353 @@
+#include "LockstepEngine.h"
+
+#include <bit>
+
+//Sets every selected lane of dst to f(lane). Computing all lanes and then selecting keeps the loop free of branches,
+//which is what lets the compiler vectorize it.
+template<class T, class F>
+static void update(std::array<T, LockstepEngine::MAX_LANES> &dst, const std::array<bool, LockstepEngine::MAX_LANES> &sel,
+                   F f)
+{
+    for (size_t lane = 0; lane < LockstepEngine::MAX_LANES; ++lane)
+    {
+        T result = f(lane);
+        dst[lane] = sel[lane] ? result : dst[lane];
+    }
+}
+
+LockstepEngine::LockstepEngine(const std::vector<byte> &ROM, size_t numLanes) : _numLanes(numLanes)
+{
+    if (numLanes == 0 || numLanes > MAX_LANES)
+    {
+        throw std::runtime_error("The number of lanes must be between 1 and " + std::to_string(MAX_LANES));
+    }
+
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        auto &newLane = _lanes.emplace_back(std::make_unique<Lane>());
+        CHIP8::loadROM(newLane->memory, ROM);
+        CHIP8::resetCpu(newLane->cpu);
+        newLane->cpu.seed(lane);
+        _storeCpu(lane);
+
+        _running |= LaneMask{1} << lane;
+    }
+}
+
+void LockstepEngine::seed(size_t lane, uint32_t seed)
+{
+    Cpu &cpu = _lanes.at(lane)->cpu;
+    cpu.seed(seed);
+    _rngState[lane] = cpu.rngState;
+}
+
+void LockstepEngine::step()
+{
+    for (size_t lane = 0; lane < _numLanes; ++lane)
+    {
+        if ((_running >> lane) & 1u && _pc[lane] & 1u) _stop(lane, "Odd address executed");
+    }
+
+    //Group the lanes by the instruction they are at, lowest address first
+    LaneMask pending = _running;
+    while (pending)
+    {
+        size_t first = std::countr_zero(pending);
+        word pc = _pc[first];
+
+        opcode opcode;
+        try
+        {
+            opcode = _lanes[first]->memory.getOpcode(pc);
+        } catch (const std::exception &e)
+        {
+            _stop(first, e.what());
+            pending &= ~(LaneMask{1} << first);
+            continue;
+        }
+
+        //Lanes that modified their code can be at the same address with a different instruction
+        LaneMask group = 0;
+        for (size_t lane = first; lane < _numLanes; ++lane)
+        {
+            bool same = (pending >> lane) & 1u && _pc[lane] == pc && _lanes[lane]->memory.getOpcode(pc) == opcode;
+            group |= LaneMask{same} << lane;
+        }
+
+        pending &= ~group;
+        _execute(pc, opcode, group);
+        _groups++;
+    }
+
+    LaneMask running = _running;
+    for (size_t lane = 0; lane < _numLanes; ++lane)
+    {
+        if (!((running >> lane) & 1u)) continue;
+
+        IO &io = _lanes[lane]->io;
+        io.pollEvents();
+        if (_soundTimer[lane]) io.beep();
+
+        if (io.getExitFlag()) _stop(lane, "");
+    }
+
+    if (++_clockCounter == CLOCKS_PER_TIMER)
+    {
+        //Stopped lanes are frozen, so only the running ones tick
+        LaneSelect sel = _select(running);
+        update(_delayTimer, sel, [&](size_t lane) { return static_cast<byte>(_delayTimer[lane] - (_delayTimer[lane] != 0)); });
+        update(_soundTimer, sel, [&](size_t lane) { return static_cast<byte>(_soundTimer[lane] - (_soundTimer[lane] != 0)); });
+        _clockCounter = 0;
+    }
+
+    _cycles++;
+}
+
+uint64_t LockstepEngine::runFor(uint64_t cycles)
+{
+    uint64_t executed = 0;
+
+    for (; executed < cycles && _running; ++executed)
+    {
+        step();
+    }
+
+    return executed;
+}
+
+void LockstepEngine::_execute(word pc, opcode opcode, LaneMask group)
+{
+    const DecodedInstruction &insn = decode(opcode);
+    LaneSelect sel = _select(group);
+
+    auto &vx = _registers[insn.x];
+    auto &vy = _registers[insn.y];
+    auto &vf = _registers[static_cast<size_t>(RegID::VF)];
+
+    //Every instruction sees the pc of the next one, like in the interpreter
+    update(_pc, sel, [&](size_t lane) { return static_cast<word>(pc + sizeof(opcode)); });
+
+    auto skipIf = [&](auto condition) {
+        update(_pc, sel, [&](size_t lane) { return static_cast<word>(_pc[lane] + (condition(lane) ? sizeof(opcode) : 0)); });
+    };
+
+    //Instructions setting VF read their operands first and write VF after the result, so the flag wins when x is VF and
+    //a VF operand is its value from before, exactly as in Instructions.cpp
+    switch (insn.op)
+    {
+        case Op::Jp_imm:
+            update(_pc, sel, [&](size_t lane) { return insn.nnn; });
+            break;
+        case Op::Se_reg_imm:
+            skipIf([&](size_t lane) { return vx[lane] == insn.kk; });
+            break;
+        case Op::Sne_reg_imm:
+            skipIf([&](size_t lane) { return vx[lane] != insn.kk; });
+            break;
+        case Op::Se_reg_reg:
+            skipIf([&](size_t lane) { return vx[lane] == vy[lane]; });
+            break;
+        case Op::Sne_reg_reg:
+            skipIf([&](size_t lane) { return vx[lane] != vy[lane]; });
+            break;
+        case Op::Ld_reg_imm:
+            update(vx, sel, [&](size_t lane) { return insn.kk; });
+            break;
+        case Op::Add_reg_imm:
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(vx[lane] + insn.kk); });
+            break;
+        case Op::Ld_reg_reg:
+            update(vx, sel, [&](size_t lane) { return vy[lane]; });
+            break;
+        case Op::Or_reg_reg:
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(vx[lane] | vy[lane]); });
+            break;
+        case Op::And_reg_reg:
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(vx[lane] & vy[lane]); });
+            break;
+        case Op::Xor_reg_reg:
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(vx[lane] ^ vy[lane]); });
+            break;
+        case Op::Add_reg_reg:
+        {
+            const auto x = vx, y = vy;
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(x[lane] + y[lane]); });
+            update(vf, sel, [&](size_t lane) { return static_cast<reg>(x[lane] + y[lane] > MAX_REG); });
+            break;
+        }
+        case Op::Sub_reg_reg:
+        {
+            const auto x = vx, y = vy;
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(x[lane] - y[lane]); });
+            update(vf, sel, [&](size_t lane) { return static_cast<reg>(x[lane] > y[lane]); });
+            break;
+        }
+        case Op::Shr_reg:
+        {
+            const auto x = vx;
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(x[lane] >> 1u); });
+            update(vf, sel, [&](size_t lane) { return static_cast<reg>(x[lane] & 1u); });
+            break;
+        }
+        case Op::Subn_reg_reg:
+        {
+            const auto x = vx, y = vy;
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(y[lane] - x[lane]); });
+            update(vf, sel, [&](size_t lane) { return static_cast<reg>(y[lane] > x[lane]); });
+            break;
+        }
+        case Op::Shl_reg:
+        {
+            const auto x = vx;
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>(x[lane] << 1u); });
+            update(vf, sel, [&](size_t lane) { return static_cast<reg>(x[lane] >> 7u); });
+            break;
+        }
+        case Op::Ld_I_imm:
+            update(_indexRegister, sel, [&](size_t lane) { return insn.nnn; });
+            break;
+        case Op::Jp_v0_imm:
+            update(_pc, sel, [&](size_t lane) { return static_cast<word>((insn.nnn + _registers[0][lane]) & MEMORY_MASK); });
+            break;
+        case Op::Rnd_reg_imm:
+            //Cpu::getRandom
+            update(_rngState, sel, [&](size_t lane) {
+                uint32_t state = _rngState[lane];
+                state ^= state << 13u;
+                state ^= state >> 17u;
+                state ^= state << 5u;
+                return state;
+            });
+            update(vx, sel, [&](size_t lane) { return static_cast<reg>((_rngState[lane] >> 24u) & insn.kk); });
+            break;
+        case Op::Ld_reg_dt:
+            update(vx, sel, [&](size_t lane) { return _delayTimer[lane]; });
+            break;
+        case Op::Ld_dt_reg:
+            update(_delayTimer, sel, [&](size_t lane) { return vx[lane]; });
+            break;
+        case Op::Ld_st_reg:
+            update(_soundTimer, sel, [&](size_t lane) { return vx[lane]; });
+            break;
+        case Op::Add_I_reg:
+            update(_indexRegister, sel, [&](size_t lane) { return static_cast<word>(_indexRegister[lane] + vx[lane]); });
+            break;
+        case Op::Ld_F_reg:
+            update(_indexRegister, sel, [&](size_t lane) { return static_cast<word>(vx[lane] * 5); });
+            break;
+        default:
+            _executeScalar(opcode, group);
+            break;
+    }
+}
+
+void LockstepEngine::_executeScalar(opcode opcode, LaneMask group)
+{
+    const Instruction &insn = parseInstruction(opcode);
+
+    for (LaneMask lanes = group; lanes; lanes &= lanes - 1)
+    {
+        size_t lane = std::countr_zero(lanes);
+        Lane &state = *_lanes[lane];
+
+        _loadCpu(lane, state.cpu);
+        try
+        {
+            insn.execute(state.cpu, state.memory, state.io);
+        } catch (const std::exception &e)
+        {
+            _stop(lane, e.what());
+        }
+        _storeCpu(lane);
+    }
+}
+
+void LockstepEngine::_stop(size_t lane, const std::string &error)
+{
+    _running &= ~(LaneMask{1} << lane);
+    _lanes[lane]->error = error;
+}
+
+void LockstepEngine::_loadCpu(size_t lane, Cpu &cpu) const
+{
+    for (size_t i = 0; i < _registers.size(); ++i)
+    {
+        cpu.registers[i] = _registers[i][lane];
+    }
+    cpu.pc = _pc[lane];
+    cpu.indexRegister = _indexRegister[lane];
+    cpu.sp = _sp[lane];
+    cpu.delayTimer = _delayTimer[lane];
+    cpu.soundTimer = _soundTimer[lane];
+    cpu.rngState = _rngState[lane];
+}
+
+void LockstepEngine::_storeCpu(size_t lane)
+{
+    const Cpu &cpu = _lanes[lane]->cpu;
+
+    for (size_t i = 0; i < _registers.size(); ++i)
+    {
+        _registers[i][lane] = cpu.registers[i];
+    }
+    _pc[lane] = cpu.pc;
+    _indexRegister[lane] = cpu.indexRegister;
+    _sp[lane] = cpu.sp;
+    _delayTimer[lane] = cpu.delayTimer;
+    _soundTimer[lane] = cpu.soundTimer;
+    _rngState[lane] = cpu.rngState;
+}
+
+LockstepEngine::LaneSelect LockstepEngine::_select(LaneMask mask)
+{
+    LaneSelect sel;
+    for (size_t lane = 0; lane < MAX_LANES; ++lane)
+    {
+        sel[lane] = (mask >> lane) & 1u;
+    }
+
+    return sel;
+}
+
+size_t LockstepEngine::getNumLanes() const
+{
+    return _numLanes;
+}
+
+LockstepEngine::LaneMask LockstepEngine::getRunningLanes() const
+{
+    return _running;
+}
+
+uint64_t LockstepEngine::getCycles() const
+{
+    return _cycles;
+}
+
+uint64_t LockstepEngine::getGroupCount() const
+{
+    return _groups;
+}
+
+MemoryBackend &LockstepEngine::getBackend(size_t lane)
+{
+    return _lanes.at(lane)->backend;
+}
+
+Cpu LockstepEngine::getCpu(size_t lane) const
+{
+    Cpu cpu = _lanes.at(lane)->cpu;
+    _loadCpu(lane, cpu);
+
+    return cpu;
+}
+
+const Memory &LockstepEngine::getMemory(size_t lane) const
+{
+    return _lanes.at(lane)->memory;
+}
+
+const std::string &LockstepEngine::getError(size_t lane) const
+{
+    return _lanes.at(lane)->error;
+}
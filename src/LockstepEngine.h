@@ -0,0 +1,114 @@
+#pragma once
+
+#include "CHIP8.h"
+#include "Cpu.h"
+#include "Memory.h"
+#include "IO.h"
+#include "MemoryBackend.h"
+#include "DecodeTable.h"
+#include "Parser.h"
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//Runs up to MAX_LANES instances of one ROM in lockstep, for evaluating it under many inputs at once. The registers,
+//pc, I, sp, timers and rnd state of all lanes are kept as arrays indexed by lane, and every cycle the lanes that are at the same
+//instruction execute it together, so register operations become a single pass over those arrays that the compiler
+//vectorizes. Lanes that diverged form separate groups until they meet again.
+//
+//Instructions touching memory, the display or the keypad run lane by lane through the regular interpreter. Every
+//lane steps exactly like a CHIP8 with a MemoryBackend and no JIT would.
+class LockstepEngine final
+{
+public:
+    static constexpr size_t MAX_LANES = 32;
+
+    //Bit n stands for lane n
+    using LaneMask = uint32_t;
+
+    //Lane n is seeded with n, see seed()
+    LockstepEngine(const std::vector<byte> &ROM, size_t numLanes);
+
+    //Seeds the lane's rnd, like CHIP8Options::seed
+    void seed(size_t lane, uint32_t seed);
+
+    //Executes a single cycle on every running lane
+    void step();
+
+    //Executes up to the given number of cycles, stopping early once no lane is running.
+    //Returns the number of cycles executed.
+    uint64_t runFor(uint64_t cycles);
+
+    [[nodiscard]] size_t getNumLanes() const;
+
+    //Lanes stop when their IO asks to exit or when they fail, see getError()
+    [[nodiscard]] LaneMask getRunningLanes() const;
+
+    [[nodiscard]] uint64_t getCycles() const;
+
+    //Number of instruction groups executed so far. Equal to getCycles() as long as the lanes never diverged.
+    [[nodiscard]] uint64_t getGroupCount() const;
+
+    //Feeds the lane's keypad and keeps its frames
+    [[nodiscard]] MemoryBackend &getBackend(size_t lane);
+
+    //A copy of the lane's registers
+    [[nodiscard]] Cpu getCpu(size_t lane) const;
+
+    [[nodiscard]] const Memory &getMemory(size_t lane) const;
+
+    //Why the lane stopped, empty if it didn't fail
+    [[nodiscard]] const std::string &getError(size_t lane) const;
+
+private:
+    //Whether each lane takes part in an operation, as a byte per lane so selects vectorize
+    using LaneSelect = std::array<bool, MAX_LANES>;
+
+    //Everything of a lane that isn't worth vectorizing
+    struct Lane
+    {
+        //Registers are only loaded in here to run an instruction through the interpreter
+        Cpu cpu;
+        Memory memory;
+        MemoryBackend backend;
+        IO io{backend};
+        std::string error;
+    };
+
+    void _execute(word pc, opcode opcode, LaneMask group);
+
+    void _executeScalar(opcode opcode, LaneMask group);
+
+    void _stop(size_t lane, const std::string &error);
+
+    //Copies the lane's registers out of the arrays, into cpu
+    void _loadCpu(size_t lane, Cpu &cpu) const;
+
+    //Copies them back from the lane's own Cpu
+    void _storeCpu(size_t lane);
+
+    static LaneSelect _select(LaneMask mask);
+
+    size_t _numLanes;
+    LaneMask _running = 0;
+
+    //_registers[reg][lane]
+    alignas(64) std::array<std::array<reg, MAX_LANES>, 16> _registers = {};
+    alignas(64) std::array<word, MAX_LANES> _pc = {};
+    alignas(64) std::array<word, MAX_LANES> _indexRegister = {};
+    alignas(64) std::array<word, MAX_LANES> _sp = {};
+    alignas(64) std::array<byte, MAX_LANES> _delayTimer = {};
+    alignas(64) std::array<byte, MAX_LANES> _soundTimer = {};
+    alignas(64) std::array<uint32_t, MAX_LANES> _rngState = {};
+
+    std::vector<std::unique_ptr<Lane>> _lanes;
+
+    uint64_t _cycles = 0;
+    uint64_t _groups = 0;
+    unsigned int _clockCounter = 0;
+};
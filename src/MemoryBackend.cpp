@@ -0,0 +1,81 @@
+#include "MemoryBackend.h"
+
+void MemoryBackend::present(const std::array<bool, NUM_PIXELS> &bitmap)
+{
+    _framebuffer = bitmap;
+    _frameCount++;
+}
+
+void MemoryBackend::pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag)
+{
+    for (auto [key, down] : _pendingEvents)
+    {
+        keys[key] = down;
+    }
+    _pendingEvents.clear();
+
+    if (_exitRequested) exitFlag = true;
+}
+
+uint64_t MemoryBackend::getIdlePolls(uint64_t max) const
+{
+    return _pendingEvents.empty() && !_exitRequested ? max : 0;
+}
+
+void MemoryBackend::beep()
+{
+    _beepCount++;
+}
+
+void MemoryBackend::press(byte key)
+{
+    if (key >= KEYPAD_SIZE) throw std::runtime_error("Invalid key");
+
+    _keys[key] = true;
+    _pendingEvents.emplace_back(key, true);
+}
+
+void MemoryBackend::release(byte key)
+{
+    if (key >= KEYPAD_SIZE) throw std::runtime_error("Invalid key");
+
+    _keys[key] = false;
+    _pendingEvents.emplace_back(key, false);
+}
+
+void MemoryBackend::setKeys(uint16_t mask)
+{
+    for (byte key = 0; key < KEYPAD_SIZE; ++key)
+    {
+        bool down = mask & (1u << key);
+        if (down == _keys[key]) continue;
+
+        if (down) press(key);
+        else release(key);
+    }
+}
+
+void MemoryBackend::requestExit()
+{
+    _exitRequested = true;
+}
+
+const std::array<bool, KEYPAD_SIZE> &MemoryBackend::getKeys() const
+{
+    return _keys;
+}
+
+const std::array<bool, NUM_PIXELS> &MemoryBackend::getFramebuffer() const
+{
+    return _framebuffer;
+}
+
+uint64_t MemoryBackend::getFrameCount() const
+{
+    return _frameCount;
+}
+
+uint64_t MemoryBackend::getBeepCount() const
+{
+    return _beepCount;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "IOBackend.h"
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//Keeps the last presented frame in memory and takes its input from the program embedding the emulator.
+//Injected input is applied on the next poll, exactly like events from a real keyboard.
+class MemoryBackend final : public IOBackend
+{
+public:
+    void present(const std::array<bool, NUM_PIXELS> &bitmap) override;
+
+    void pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag) override;
+
+    //Idle as long as nothing was injected
+    [[nodiscard]] uint64_t getIdlePolls(uint64_t max) const override;
+
+    void beep() override;
+
+    void press(byte key);
+
+    void release(byte key);
+
+    //Presses and releases keys so that exactly the keys set in the mask (bit n for key n) are down
+    void setKeys(uint16_t mask);
+
+    void requestExit();
+
+    [[nodiscard]] const std::array<bool, KEYPAD_SIZE> &getKeys() const;
+
+    [[nodiscard]] const std::array<bool, NUM_PIXELS> &getFramebuffer() const;
+
+    [[nodiscard]] uint64_t getFrameCount() const;
+
+    [[nodiscard]] uint64_t getBeepCount() const;
+
+private:
+    //Key and whether it went down, in the order they were injected
+    std::vector<std::pair<byte, bool>> _pendingEvents;
+    std::array<bool, KEYPAD_SIZE> _keys = {};
+    bool _exitRequested = false;
+
+    std::array<bool, NUM_PIXELS> _framebuffer = {};
+    uint64_t _frameCount = 0;
+    uint64_t _beepCount = 0;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "IOBackend.h"
+
+//Shows nothing, reads no input and makes no sound. The machine still keeps its framebuffer and keypad, so running
+//on this is exactly like running with a display nobody is looking at.
+class NullBackend final : public IOBackend
+{
+public:
+    void present(const std::array<bool, NUM_PIXELS> &bitmap) override
+    {}
+
+    void pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag) override
+    {}
+
+    [[nodiscard]] uint64_t getIdlePolls(uint64_t max) const override
+    {
+        return max;
+    }
+
+    void beep() override
+    {}
+};
@@ -4,10 +4,13 @@
 #include "Instruction.h"
 #include "types.h"
 #include "RegID.h"
+#include "DecodeTable.h"
 
 #include <stdexcept>
 #include <memory>
+#include <array>
+#include <atomic>
 
-using InstructionPtr = std::unique_ptr<Instruction>;
-
-InstructionPtr parseInstruction(opcode opcode);
\ No newline at end of file
+//Returns the instruction for the opcode. Every opcode has one shared instance, created the first time the opcode is
+//parsed and kept for the rest of the process, so parsing never allocates after that.
+const Instruction &parseInstruction(opcode opcode);
\ No newline at end of file
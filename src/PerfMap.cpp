@@ -0,0 +1,124 @@
+#include "PerfMap.h"
+
+#include <stdexcept>
+#include <ctime>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//See tools/perf/Documentation/jitdump-specification.txt in the kernel tree
+constexpr uint32_t JITDUMP_MAGIC = 0x4a695444;
+constexpr uint32_t JITDUMP_VERSION = 1;
+constexpr uint32_t JIT_CODE_LOAD = 0;
+constexpr uint32_t JIT_CODE_CLOSE = 3;
+
+struct JitdumpHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalSize;
+    uint32_t elfMach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+};
+
+struct JitdumpRecordHeader
+{
+    uint32_t id;
+    uint32_t totalSize;
+    uint64_t timestamp;
+};
+
+struct JitdumpCodeLoad
+{
+    JitdumpRecordHeader header;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t codeAddr;
+    uint64_t codeSize;
+    uint64_t codeIndex;
+    //Followed by the name, null terminated, and the code
+};
+
+//perf record -k mono timestamps with the same clock
+static uint64_t timestamp()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+PerfMap::PerfMap(bool perfMap, const std::string &jitdumpDir)
+{
+    if (perfMap)
+    {
+        std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+        _map = std::fopen(path.c_str(), "w");
+        if (_map == nullptr) throw std::runtime_error("Failed to open " + path);
+    }
+
+    if (!jitdumpDir.empty())
+    {
+        std::string path = jitdumpDir + "/jit-" + std::to_string(getpid()) + ".dump";
+        _jitdump = std::fopen(path.c_str(), "w+");
+        if (_jitdump == nullptr) throw std::runtime_error("Failed to open " + path);
+
+        JitdumpHeader header{JITDUMP_MAGIC, JITDUMP_VERSION, sizeof(JitdumpHeader), EM_X86_64, 0,
+                             static_cast<uint32_t>(getpid()), timestamp(), 0};
+        std::fwrite(&header, sizeof(header), 1, _jitdump);
+        std::fflush(_jitdump);
+
+        _markerSize = sysconf(_SC_PAGESIZE);
+        _marker = mmap(nullptr, _markerSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(_jitdump), 0);
+        if (_marker == MAP_FAILED) throw std::runtime_error("Failed to map " + path);
+    }
+}
+
+PerfMap::~PerfMap()
+{
+    if (_map != nullptr) std::fclose(_map);
+
+    if (_jitdump != nullptr)
+    {
+        JitdumpRecordHeader close{JIT_CODE_CLOSE, sizeof(JitdumpRecordHeader), timestamp()};
+        std::fwrite(&close, sizeof(close), 1, _jitdump);
+
+        munmap(_marker, _markerSize);
+        std::fclose(_jitdump);
+    }
+}
+
+void PerfMap::add(const void *code, size_t size, const std::string &name)
+{
+    auto addr = reinterpret_cast<uintptr_t>(code);
+
+    if (_map != nullptr)
+    {
+        std::fprintf(_map, "%lx %zx %s\n", static_cast<unsigned long>(addr), size, name.c_str());
+        std::fflush(_map);
+    }
+
+    if (_jitdump != nullptr)
+    {
+        JitdumpCodeLoad load{};
+        load.header.id = JIT_CODE_LOAD;
+        load.header.totalSize = sizeof(load) + name.size() + 1 + size;
+        load.header.timestamp = timestamp();
+        load.pid = getpid();
+        load.tid = syscall(SYS_gettid);
+        load.vma = addr;
+        load.codeAddr = addr;
+        load.codeSize = size;
+        load.codeIndex = _codeIndex++;
+
+        std::fwrite(&load, sizeof(load), 1, _jitdump);
+        std::fwrite(name.c_str(), name.size() + 1, 1, _jitdump);
+        std::fwrite(code, size, 1, _jitdump);
+        std::fflush(_jitdump);
+    }
+}
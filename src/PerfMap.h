@@ -0,0 +1,42 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+//Tells Linux perf what the compiled sections are, so host profiles attribute their samples to guest functions instead
+//of [unknown] addresses. Two ways, either or both:
+//
+//- /tmp/perf-<pid>.map, which perf report reads on its own. Names only.
+//- <dir>/jit-<pid>.dump in the jitdump format, which also carries the code bytes so perf annotate can disassemble
+//  the sections. Record with `perf record -k mono` and run `perf inject --jit` on the result before reporting.
+//
+//Sections can be released and their addresses reused, the latest entry for an address is the one that counts.
+class PerfMap final
+{
+public:
+    //Writes the map if perfMap is set, and a jitdump into jitdumpDir unless it's empty
+    PerfMap(bool perfMap, const std::string &jitdumpDir);
+
+    ~PerfMap();
+
+    PerfMap(const PerfMap &) = delete;
+
+    PerfMap &operator=(const PerfMap &) = delete;
+
+    //Not thread safe, the JITCache calls it under its lock
+    void add(const void *code, size_t size, const std::string &name);
+
+private:
+    FILE *_map = nullptr;
+
+    FILE *_jitdump = nullptr;
+    //perf finds the jitdump through an executable mapping of it
+    void *_marker = nullptr;
+    size_t _markerSize = 0;
+
+    uint64_t _codeIndex = 0;
+};
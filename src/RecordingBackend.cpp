@@ -0,0 +1,44 @@
+#include "RecordingBackend.h"
+
+RecordingBackend::RecordingBackend(IOBackend &backend, InputLogWriter &log) : _backend(backend), _log(log)
+{}
+
+RecordingBackend::~RecordingBackend()
+{
+    _log.finish(_cycle);
+}
+
+void RecordingBackend::present(const std::array<bool, NUM_PIXELS> &bitmap)
+{
+    _backend.present(bitmap);
+}
+
+void RecordingBackend::pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag)
+{
+    //The machine changes the keypad too (ld Vx, K takes the key), so only what the backend changes is logged
+    uint16_t before = keysToMask(keys);
+    _backend.pollEvents(keys, exitFlag);
+    uint16_t after = keysToMask(keys);
+
+    if (after != before) _log.record(_cycle, after);
+    if (exitFlag) _log.finish(_cycle);
+
+    _cycle++;
+}
+
+uint64_t RecordingBackend::getIdlePolls(uint64_t max) const
+{
+    return _backend.getIdlePolls(max);
+}
+
+void RecordingBackend::skipPolls(uint64_t count)
+{
+    //Whatever comes in meanwhile is logged at the next poll, and replaying skips to exactly that poll
+    _backend.skipPolls(count);
+    _cycle += count;
+}
+
+void RecordingBackend::beep()
+{
+    _backend.beep();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "IOBackend.h"
+#include "InputLog.h"
+
+//Passes everything through to another backend, and logs every change it makes to the keypad
+class RecordingBackend final : public IOBackend
+{
+public:
+    //Both have to outlive the RecordingBackend
+    RecordingBackend(IOBackend &backend, InputLogWriter &log);
+
+    //Ends the log at the last cycle polled, unless the session already exited
+    ~RecordingBackend() override;
+
+    void present(const std::array<bool, NUM_PIXELS> &bitmap) override;
+
+    void pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag) override;
+
+    [[nodiscard]] uint64_t getIdlePolls(uint64_t max) const override;
+
+    void skipPolls(uint64_t count) override;
+
+    void beep() override;
+
+private:
+    IOBackend &_backend;
+    InputLogWriter &_log;
+
+    uint64_t _cycle = 0;
+};
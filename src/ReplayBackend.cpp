@@ -0,0 +1,58 @@
+#include "ReplayBackend.h"
+
+#include <algorithm>
+
+ReplayBackend::ReplayBackend(const InputLog &log) : _log(log)
+{}
+
+void ReplayBackend::present(const std::array<bool, NUM_PIXELS> &bitmap)
+{
+    _framebuffer = bitmap;
+}
+
+void ReplayBackend::pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag)
+{
+    if (_nextChange < _log.changes.size() && _log.changes[_nextChange].cycle == _cycle)
+    {
+        keys = maskToKeys(_log.changes[_nextChange++].keys);
+    }
+
+    if (_log.endCycle.has_value())
+    {
+        if (_cycle >= _log.endCycle.value()) exitFlag = true;
+    } else if (_nextChange == _log.changes.size())
+    {
+        exitFlag = true;
+    }
+
+    _cycle++;
+}
+
+uint64_t ReplayBackend::getIdlePolls(uint64_t max) const
+{
+    //Up to the next change, or the exit
+    if (_nextChange < _log.changes.size()) max = std::min(max, _log.changes[_nextChange].cycle - _cycle);
+
+    if (_log.endCycle.has_value())
+    {
+        max = _cycle < _log.endCycle.value() ? std::min(max, _log.endCycle.value() - _cycle) : 0;
+    } else if (_nextChange == _log.changes.size())
+    {
+        max = 0;
+    }
+
+    return max;
+}
+
+void ReplayBackend::skipPolls(uint64_t count)
+{
+    _cycle += count;
+}
+
+void ReplayBackend::beep()
+{}
+
+const std::array<bool, NUM_PIXELS> &ReplayBackend::getFramebuffer() const
+{
+    return _framebuffer;
+}
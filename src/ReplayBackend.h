@@ -0,0 +1,32 @@
+#pragma once
+
+#include "IOBackend.h"
+#include "InputLog.h"
+
+//Feeds the keypad from an InputLog, at the exact cycles it was recorded at, and exits where the session did (or after
+//the last change, if the recording was cut short). Shows nothing.
+class ReplayBackend final : public IOBackend
+{
+public:
+    //The log has to outlive the ReplayBackend
+    explicit ReplayBackend(const InputLog &log);
+
+    void present(const std::array<bool, NUM_PIXELS> &bitmap) override;
+
+    void pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag) override;
+
+    [[nodiscard]] uint64_t getIdlePolls(uint64_t max) const override;
+
+    void skipPolls(uint64_t count) override;
+
+    void beep() override;
+
+    [[nodiscard]] const std::array<bool, NUM_PIXELS> &getFramebuffer() const;
+
+private:
+    const InputLog &_log;
+    size_t _nextChange = 0;
+    uint64_t _cycle = 0;
+
+    std::array<bool, NUM_PIXELS> _framebuffer = {};
+};
@@ -0,0 +1,141 @@
+#include "RewindBuffer.h"
+
+//Deltas are a sequence of (number of zeros, number of literals, literals) with LEB128 counts, covering the state.
+
+static void writeVarint(std::vector<byte> &out, size_t value)
+{
+    do
+    {
+        byte b = value & 0x7fu;
+        value >>= 7u;
+        out.push_back(b | (value ? 0x80u : 0u));
+    } while (value);
+}
+
+static size_t readVarint(const byte *&in)
+{
+    size_t value = 0;
+    for (unsigned int shift = 0;; shift += 7)
+    {
+        byte b = *in++;
+        value |= static_cast<size_t>(b & 0x7fu) << shift;
+        if (!(b & 0x80u)) return value;
+    }
+}
+
+RewindBuffer::RewindBuffer(size_t stateSize, size_t capacity) : _stateSize(stateSize), _latest(stateSize),
+                                                                _ring(capacity)
+{
+    _scratch.reserve(stateSize * 2);
+}
+
+void RewindBuffer::push(const byte *state)
+{
+    if (_hasLatest)
+    {
+        _encode(state);
+        _store();
+    }
+
+    std::memcpy(_latest.data(), state, _stateSize);
+    _hasLatest = true;
+}
+
+size_t RewindBuffer::rewind(size_t frames, byte *state)
+{
+    if (!_hasLatest) throw std::runtime_error("Nothing to rewind to");
+
+    size_t rewound = 0;
+    for (; rewound < frames && !_entries.empty(); ++rewound)
+    {
+        _apply(_entries.back());
+        _head = _entries.back().offset;
+        _entries.pop_back();
+    }
+
+    std::memcpy(state, _latest.data(), _stateSize);
+    return rewound;
+}
+
+size_t RewindBuffer::getNumFrames() const
+{
+    return _entries.size();
+}
+
+void RewindBuffer::_encode(const byte *state)
+{
+    _scratch.clear();
+
+    size_t pos = 0;
+    while (pos < _stateSize)
+    {
+        size_t zeros = 0;
+        while (pos + zeros < _stateSize && state[pos + zeros] == _latest[pos + zeros]) zeros++;
+        pos += zeros;
+
+        //A literal run ends at the first two unchanged bytes in a row, a single one is cheaper to keep inline
+        size_t literals = 0;
+        while (pos + literals < _stateSize &&
+               (state[pos + literals] != _latest[pos + literals] ||
+                (pos + literals + 1 < _stateSize && state[pos + literals + 1] != _latest[pos + literals + 1])))
+        {
+            literals++;
+        }
+
+        writeVarint(_scratch, zeros);
+        writeVarint(_scratch, literals);
+        for (size_t i = 0; i < literals; ++i)
+        {
+            _scratch.push_back(state[pos + i] ^ _latest[pos + i]);
+        }
+        pos += literals;
+    }
+}
+
+void RewindBuffer::_apply(const Entry &entry)
+{
+    const byte *in = _ring.data() + entry.offset;
+    const byte *end = in + entry.size;
+
+    size_t pos = 0;
+    while (in < end)
+    {
+        pos += readVarint(in);
+        size_t literals = readVarint(in);
+        for (size_t i = 0; i < literals; ++i)
+        {
+            _latest[pos + i] ^= in[i];
+        }
+        in += literals;
+        pos += literals;
+    }
+}
+
+void RewindBuffer::_store()
+{
+    size_t size = _scratch.size();
+
+    //Doesn't fit at all, the history before this frame is lost
+    if (size > _ring.size())
+    {
+        _entries.clear();
+        _head = 0;
+        return;
+    }
+
+    if (_head + size > _ring.size()) _head = 0;
+
+    //Frames older than one that gets overwritten can't be reached anymore, so everything up to the newest frame in
+    //the way goes
+    size_t numEvicted = 0;
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        const Entry &entry = _entries[i];
+        if (entry.offset < _head + size && entry.offset + entry.size > _head) numEvicted = i + 1;
+    }
+    _entries.erase(_entries.begin(), _entries.begin() + numEvicted);
+
+    std::memcpy(_ring.data() + _head, _scratch.data(), size);
+    _entries.push_back(Entry{_head, size});
+    _head += size;
+}
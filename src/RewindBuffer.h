@@ -0,0 +1,54 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+//Fixed-size history of a state of constant size. Every pushed state is kept as the XOR of it and the state before it,
+//with its runs of zeros (everything that didn't change) squeezed out, so a frame usually takes a few dozen bytes.
+//Once the memory is used up, the oldest frames are dropped.
+class RewindBuffer final
+{
+public:
+    RewindBuffer(size_t stateSize, size_t capacity);
+
+    //Records state as the newest frame
+    void push(const byte *state);
+
+    //Goes back up to the given number of frames before the newest one, writes that frame to state and makes it the
+    //newest. Returns the number of frames it went back.
+    size_t rewind(size_t frames, byte *state);
+
+    //Number of frames that can be gone back
+    [[nodiscard]] size_t getNumFrames() const;
+
+private:
+    struct Entry
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    void _encode(const byte *state);
+
+    void _apply(const Entry &entry);
+
+    void _store();
+
+    size_t _stateSize;
+
+    //The newest frame, in full. Older ones are recovered by applying deltas to it.
+    std::vector<byte> _latest;
+    bool _hasLatest = false;
+
+    std::vector<byte> _ring;
+    size_t _head = 0;
+    //Oldest first
+    std::deque<Entry> _entries;
+
+    std::vector<byte> _scratch;
+};
@@ -0,0 +1,34 @@
+#include "RunConditions.h"
+
+std::ostream &operator<<(std::ostream &stream, StopReason reason)
+{
+    switch (reason)
+    {
+        case StopReason::Exit:
+            return stream << "exit";
+        case StopReason::Breakpoint:
+            return stream << "breakpoint";
+        case StopReason::Cycles:
+            return stream << "cycles";
+        case StopReason::Frames:
+            return stream << "frames";
+        case StopReason::Framebuffer:
+            return stream << "framebuffer";
+        case StopReason::Memory:
+            return stream << "memory";
+    }
+
+    return stream << "unknown";
+}
+
+uint64_t hashFramebuffer(const std::array<bool, NUM_PIXELS> &bitmap)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (bool pixel : bitmap)
+    {
+        hash ^= pixel;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
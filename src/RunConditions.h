@@ -0,0 +1,58 @@
+#pragma once
+
+#include "constants.h"
+#include "IOBackend.h"
+#include "types.h"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+//Why CHIP8::runUntil() returned
+enum class StopReason : byte
+{
+    //The IO asked to exit
+    Exit,
+    Breakpoint,
+    Cycles,
+    Frames,
+    Framebuffer,
+    Memory,
+};
+
+std::ostream &operator<<(std::ostream &stream, StopReason reason);
+
+//When CHIP8::runUntil() should stop, whichever comes first. A frame ends every time the timers tick.
+//
+//Breakpoints are checked before every instruction the interpreter executes, and compiled sections hand back to the
+//interpreter at them. The cycle and frame limits are exact. The framebuffer and memory are only looked at on frame
+//boundaries, so watching them costs nothing in between.
+struct RunConditions
+{
+    //Stop before executing any of these addresses
+    std::bitset<MEMORY_SIZE> breakpoints;
+
+    //Stop once CHIP8::getCycles() reaches this
+    std::optional<uint64_t> cycles;
+
+    //Stop once CHIP8::getFrames() reaches this
+    std::optional<uint64_t> frames;
+
+    //Stop at the first frame boundary where the framebuffer hashes to this, see hashFramebuffer()
+    std::optional<uint64_t> framebufferHash;
+
+    struct MemoryValue
+    {
+        word addr;
+        byte value;
+    };
+
+    //Stop at the first frame boundary where any of these bytes holds its value
+    std::vector<MemoryValue> memoryValues;
+};
+
+//FNV-1a over the pixels. This is the hash the tools print and RunConditions::framebufferHash expects.
+uint64_t hashFramebuffer(const std::array<bool, NUM_PIXELS> &bitmap);
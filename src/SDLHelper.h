@@ -1,6 +1,6 @@
 #pragma once
 
-//IO.h, IO.cpp, SDLHelper.h, SDLHelper.cpp, are almost fully copied, with minor changes, from https://github.com/omerk2511/chip-8 .
+//IO.h, IO.cpp, SDLBackend.h, SDLBackend.cpp, SDLHelper.h, SDLHelper.cpp, are almost fully copied, with minor changes, from https://github.com/omerk2511/chip-8 .
 //
 //MIT License
 //
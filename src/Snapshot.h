@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Cpu.h"
+#include "IOBackend.h"
+#include "constants.h"
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+//Immutable copy of a buffer, kept as chunks that are shared with every other copy whose contents are the same there.
+//Copying one only copies the pointers.
+template<size_t SIZE>
+class ChunkedCopy
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 0x100;
+    static constexpr size_t NUM_CHUNKS = SIZE / CHUNK_SIZE;
+
+    static_assert(SIZE % CHUNK_SIZE == 0);
+
+    using Chunk = std::array<byte, CHUNK_SIZE>;
+
+    //Copies data, reusing the chunks of base that hold the same bytes
+    explicit ChunkedCopy(const byte *data, const ChunkedCopy *base = nullptr)
+    {
+        for (size_t i = 0; i < NUM_CHUNKS; ++i)
+        {
+            const byte *src = data + i * CHUNK_SIZE;
+            if (base != nullptr && std::memcmp(base->_chunks[i]->data(), src, CHUNK_SIZE) == 0)
+            {
+                _chunks[i] = base->_chunks[i];
+                continue;
+            }
+
+            auto chunk = std::make_shared<Chunk>();
+            std::memcpy(chunk->data(), src, CHUNK_SIZE);
+            _chunks[i] = std::move(chunk);
+        }
+    }
+
+    [[nodiscard]] const byte *chunk(size_t index) const
+    {
+        return _chunks[index]->data();
+    }
+
+    void copyTo(byte *data) const
+    {
+        for (size_t i = 0; i < NUM_CHUNKS; ++i)
+        {
+            std::memcpy(data + i * CHUNK_SIZE, chunk(i), CHUNK_SIZE);
+        }
+    }
+
+private:
+    std::array<std::shared_ptr<const Chunk>, NUM_CHUNKS> _chunks;
+};
+
+//Everything needed to put a CHIP8 back to the point it was taken at. Snapshots are cheap to copy and to keep around
+//in large numbers, see ChunkedCopy.
+struct Snapshot
+{
+    Cpu cpu;
+    ChunkedCopy<MEMORY_SIZE> memory;
+    ChunkedCopy<MEMORY_SIZE / 2> dirtyMap;
+    ChunkedCopy<NUM_PIXELS> framebuffer;
+    std::array<bool, KEYPAD_SIZE> keys;
+
+    uint64_t cycles;
+    //Cycles since the timers last ticked
+    unsigned int clockCounter;
+};
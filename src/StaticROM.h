@@ -0,0 +1,24 @@
+#pragma once
+
+#include "types.h"
+
+#include <vector>
+
+//A section compiled by chip8_recompiler, ready to be preloaded into the JITCache.
+struct PrecompiledSection
+{
+    word addr;
+    std::vector<byte> guest;
+    std::vector<byte> code;
+    //Instructions of guest the code covers
+    word numCompiled;
+};
+
+struct StaticROM
+{
+    std::vector<byte> rom;
+    std::vector<PrecompiledSection> sections;
+};
+
+//Defined by the source chip8_recompiler generates for every statically recompiled ROM.
+extern const StaticROM STATIC_ROM;
@@ -0,0 +1,114 @@
+#include "TraceRing.h"
+#include "BinaryFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+static constexpr char MAGIC[4] = {'C', '8', 'T', 'R'};
+static constexpr byte VERSION = 1;
+
+TraceRing::TraceRing(size_t capacity)
+        : _entries(std::make_unique<TraceEntry[]>(std::bit_ceil(std::max<size_t>(capacity, 1)))),
+          _mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1)
+{
+}
+
+std::vector<TraceEntry> TraceRing::getEntries() const
+{
+    uint64_t count = std::min<uint64_t>(_next, getCapacity());
+
+    std::vector<TraceEntry> entries;
+    entries.reserve(count);
+    for (uint64_t i = _next - count; i < _next; ++i)
+    {
+        entries.push_back(_entries[i & _mask]);
+    }
+
+    return entries;
+}
+
+size_t TraceRing::getCapacity() const
+{
+    return _mask + 1;
+}
+
+void writeTrace(const char *filename, const TraceRing &ring, const Cpu &cpu, uint64_t cycles,
+                const std::string &message)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) throw std::runtime_error(std::string("Failed to open ") + filename);
+
+    file.write(MAGIC, sizeof(MAGIC));
+    file.put(static_cast<char>(VERSION));
+    writeLE<uint64_t>(file, cycles);
+    writeLE<word>(file, cpu.pc);
+    writeLE<word>(file, cpu.indexRegister);
+    writeLE<word>(file, cpu.sp);
+    for (reg r : cpu.registers)
+    {
+        file.put(static_cast<char>(r));
+    }
+    file.put(static_cast<char>(cpu.delayTimer));
+    file.put(static_cast<char>(cpu.soundTimer));
+
+    writeLE<uint32_t>(file, message.size());
+    file.write(message.data(), message.size());
+
+    std::vector<TraceEntry> entries = ring.getEntries();
+    writeLE<uint32_t>(file, entries.size());
+    for (const TraceEntry &entry : entries)
+    {
+        writeLE<uint64_t>(file, entry.cycle);
+        writeLE<word>(file, entry.pc);
+        writeLE<opcode>(file, entry.opcode);
+        writeLE<word>(file, entry.indexRegister);
+        writeLE<word>(file, entry.sp);
+    }
+
+    if (!file.flush()) throw std::runtime_error(std::string("Failed to write ") + filename);
+}
+
+Trace readTrace(const char *filename)
+{
+    std::vector<byte> data = readBinaryFile(filename);
+
+    if (data.size() <= sizeof(MAGIC) || !std::equal(std::begin(MAGIC), std::end(MAGIC), data.begin()))
+    {
+        throw std::runtime_error(std::string(filename) + " is not a trace");
+    }
+    if (data[sizeof(MAGIC)] != VERSION) throw std::runtime_error("Unsupported trace version");
+
+    size_t pos = sizeof(MAGIC) + 1;
+
+    Trace trace;
+    trace.cycles = readLE<uint64_t>(data, pos);
+    trace.pc = readLE<word>(data, pos);
+    trace.indexRegister = readLE<word>(data, pos);
+    trace.sp = readLE<word>(data, pos);
+    for (reg &r : trace.registers)
+    {
+        r = readLE<byte>(data, pos);
+    }
+    trace.delayTimer = readLE<byte>(data, pos);
+    trace.soundTimer = readLE<byte>(data, pos);
+
+    uint32_t messageSize = readLE<uint32_t>(data, pos);
+    if (pos + messageSize > data.size()) throw std::runtime_error("Unexpected end of file");
+    trace.message.assign(data.begin() + pos, data.begin() + pos + messageSize);
+    pos += messageSize;
+
+    uint32_t numEntries = readLE<uint32_t>(data, pos);
+    for (uint32_t i = 0; i < numEntries; ++i)
+    {
+        TraceEntry entry{};
+        entry.cycle = readLE<uint64_t>(data, pos);
+        entry.pc = readLE<word>(data, pos);
+        entry.opcode = readLE<opcode>(data, pos);
+        entry.indexRegister = readLE<word>(data, pos);
+        entry.sp = readLE<word>(data, pos);
+        trace.entries.push_back(entry);
+    }
+
+    return trace;
+}
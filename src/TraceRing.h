@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Cpu.h"
+#include "types.h"
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//One interpreted instruction, as it was about to execute
+struct TraceEntry
+{
+    uint64_t cycle;
+    word pc;
+    ::opcode opcode;
+    word indexRegister;
+    word sp;
+};
+
+//The last instructions a CHIP8 executed, for finding out how it got to an error. Recording is a store into a fixed
+//array, without locks, branches or formatting, and the ring is only ever read once the machine stopped. Instances
+//don't share anything, so each belongs to the thread running its CHIP8.
+class TraceRing final
+{
+public:
+    //Rounded up to a power of two, at least 1
+    explicit TraceRing(size_t capacity);
+
+    void record(uint64_t cycle, word pc, opcode opcode, word indexRegister, word sp)
+    {
+        _entries[_next++ & _mask] = TraceEntry{cycle, pc, opcode, indexRegister, sp};
+    }
+
+    //Oldest first
+    [[nodiscard]] std::vector<TraceEntry> getEntries() const;
+
+    [[nodiscard]] size_t getCapacity() const;
+
+private:
+    std::unique_ptr<TraceEntry[]> _entries;
+    size_t _mask;
+    uint64_t _next = 0;
+};
+
+//A trace as written by writeTrace(). On disk, all little endian:
+//  "C8TR", version, cycles (u64), pc, I, sp (u16), V0 to VF, delay and sound timers
+//  the length of the message (u32) and the message
+//  the number of entries (u32), then per entry oldest first: cycle (u64), pc, opcode, I, sp (u16)
+struct Trace
+{
+    //The machine when the trace was written
+    uint64_t cycles;
+    word pc;
+    word indexRegister;
+    word sp;
+    reg registers[16];
+    byte delayTimer;
+    byte soundTimer;
+
+    //Why it was written, usually the error the machine stopped on
+    std::string message;
+
+    std::vector<TraceEntry> entries;
+};
+
+void writeTrace(const char *filename, const TraceRing &ring, const Cpu &cpu, uint64_t cycles,
+                const std::string &message);
+
+Trace readTrace(const char *filename);
@@ -0,0 +1,381 @@
+#include "CHIP8.h"
+#include "BinaryFile.h"
+#include "CompilePool.h"
+#include "MemoryBackend.h"
+#include "RunConditions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Batch runner: runs every ROM/input pair of a manifest headless, on a fixed set of threads, and prints one result
+//line per run.
+//
+//Every manifest line is a run: "<rom> <cycles> [input script] [condition...]", paths being relative to the manifest.
+//Input scripts have a "<cycle> <key> <1|0>" line per key press (1) or release (0), the key in hex. Events apply
+//before the cycle they name executes. Empty lines and lines starting with # are ignored in both. Runs are seeded with
+//their index, so a manifest always gives the same results.
+//
+//Conditions end a run before its cycles are up, see RunConditions. Addresses, values and hashes are in hex:
+//  break=<addr>[,<addr>...]  before executing any of the addresses
+//  frames=<n>                once the timers ticked n times
+//  fb=<hash>                 once the framebuffer hashes to the given value, as printed in the results
+//  mem=<addr>:<value>        once the byte at addr holds value. May be given more than once.
+
+struct InputEvent
+{
+    uint64_t cycle;
+    byte key;
+    bool down;
+};
+
+struct Run
+{
+    std::string romPath;
+    std::string inputPath;
+    uint64_t cycles;
+    RunConditions conditions;
+
+    std::shared_ptr<const std::vector<byte>> rom;
+    std::shared_ptr<const std::vector<InputEvent>> input;
+};
+
+struct RunResult
+{
+    bool ok = false;
+    std::string error;
+    std::optional<StopReason> stop;
+    uint64_t cycles = 0;
+    uint64_t frames = 0;
+    uint64_t framebufferHash = 0;
+    double milliseconds = 0;
+};
+
+//Per-thread deques of run indices. A thread takes runs from the back of its own deque and, once that's empty, steals
+//from the front of the others'. Runs are coarse, so a lock per deque costs nothing next to running them.
+class WorkStealingQueue final
+{
+public:
+    WorkStealingQueue(size_t numRuns, size_t numThreads) : _deques(numThreads)
+    {
+        //Round robin, so neighbouring manifest lines (often the same ROM) spread evenly over the threads
+        for (size_t i = 0; i < numRuns; ++i)
+        {
+            _deques[i % numThreads].runs.push_back(i);
+        }
+    }
+
+    std::optional<size_t> next(size_t thread)
+    {
+        {
+            Deque &own = _deques[thread];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.runs.empty())
+            {
+                size_t run = own.runs.back();
+                own.runs.pop_back();
+                return run;
+            }
+        }
+
+        for (size_t i = 1; i < _deques.size(); ++i)
+        {
+            Deque &victim = _deques[(thread + i) % _deques.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.runs.empty())
+            {
+                size_t run = victim.runs.front();
+                victim.runs.pop_front();
+                return run;
+            }
+        }
+
+        //Nothing creates runs once we started, so empty everywhere means done
+        return std::nullopt;
+    }
+
+private:
+    struct Deque
+    {
+        std::mutex mutex;
+        std::deque<size_t> runs;
+    };
+
+    std::vector<Deque> _deques;
+};
+
+static std::vector<InputEvent> readInputScript(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) throw std::runtime_error("Failed to open " + path);
+
+    std::vector<InputEvent> events;
+    std::string line;
+    for (size_t lineNum = 1; std::getline(file, line); ++lineNum)
+    {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        uint64_t cycle;
+        unsigned int key, down;
+        if (!(fields >> std::dec >> cycle >> std::hex >> key >> std::dec >> down) || key >= KEYPAD_SIZE || down > 1)
+        {
+            throw std::runtime_error(path + ":" + std::to_string(lineNum) + ": Invalid input event");
+        }
+
+        events.push_back(InputEvent{cycle, static_cast<byte>(key), down == 1});
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const InputEvent &a, const InputEvent &b) {
+        return a.cycle < b.cycle;
+    });
+
+    return events;
+}
+
+static unsigned long parseHex(const std::string &text, unsigned long max)
+{
+    size_t end;
+    unsigned long value = std::stoul(text, &end, 16);
+    if (end != text.size() || value > max) throw std::invalid_argument(text);
+
+    return value;
+}
+
+static void parseCondition(const std::string &token, RunConditions &conditions)
+{
+    size_t equals = token.find('=');
+    if (equals == std::string::npos) throw std::invalid_argument(token);
+
+    std::string name = token.substr(0, equals);
+    std::string value = token.substr(equals + 1);
+
+    if (name == "break")
+    {
+        std::istringstream addrs(value);
+        std::string addr;
+        while (std::getline(addrs, addr, ','))
+        {
+            conditions.breakpoints.set(parseHex(addr, MEMORY_MASK));
+        }
+    } else if (name == "frames")
+    {
+        conditions.frames = std::stoull(value);
+    } else if (name == "fb")
+    {
+        conditions.framebufferHash = std::stoull(value, nullptr, 16);
+    } else if (name == "mem")
+    {
+        size_t colon = value.find(':');
+        if (colon == std::string::npos) throw std::invalid_argument(token);
+
+        conditions.memoryValues.push_back(RunConditions::MemoryValue{
+                static_cast<word>(parseHex(value.substr(0, colon), MEMORY_MASK)),
+                static_cast<byte>(parseHex(value.substr(colon + 1), 0xff))});
+    } else
+    {
+        throw std::invalid_argument(token);
+    }
+}
+
+static std::vector<Run> readManifest(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) throw std::runtime_error("Failed to open " + path);
+
+    std::filesystem::path base = std::filesystem::path(path).parent_path();
+
+    //Every ROM and script is read once, however many runs use it
+    std::map<std::string, std::shared_ptr<const std::vector<byte>>> roms;
+    std::map<std::string, std::shared_ptr<const std::vector<InputEvent>>> inputs;
+
+    std::vector<Run> runs;
+    std::string line;
+    for (size_t lineNum = 1; std::getline(file, line); ++lineNum)
+    {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        Run run;
+        if (!(fields >> run.romPath >> run.cycles))
+        {
+            throw std::runtime_error(path + ":" + std::to_string(lineNum) +
+                                     ": Expected <rom> <cycles> [input] [condition...]");
+        }
+
+        for (std::string token; fields >> token;)
+        {
+            if (token.find('=') == std::string::npos && run.inputPath.empty())
+            {
+                run.inputPath = token;
+                continue;
+            }
+
+            try
+            {
+                parseCondition(token, run.conditions);
+            } catch (const std::exception &)
+            {
+                throw std::runtime_error(path + ":" + std::to_string(lineNum) + ": Invalid condition " + token);
+            }
+        }
+
+        std::string romFile = (base / run.romPath).string();
+        if (!roms.contains(romFile))
+        {
+            roms[romFile] = std::make_shared<const std::vector<byte>>(readBinaryFile(romFile.c_str()));
+        }
+        run.rom = roms[romFile];
+
+        if (!run.inputPath.empty())
+        {
+            std::string inputFile = (base / run.inputPath).string();
+            if (!inputs.contains(inputFile))
+            {
+                inputs[inputFile] = std::make_shared<const std::vector<InputEvent>>(readInputScript(inputFile));
+            }
+            run.input = inputs[inputFile];
+        }
+
+        runs.push_back(std::move(run));
+    }
+
+    return runs;
+}
+
+static RunResult execute(const Run &run, uint32_t seed, CompilePool &pool)
+{
+    RunResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    MemoryBackend backend;
+
+    try
+    {
+        CHIP8Options options;
+        options.compilePool = &pool;
+        options.seed = seed;
+
+        CHIP8 chip8(*run.rom, backend, options);
+
+        static const std::vector<InputEvent> NO_INPUT;
+        const std::vector<InputEvent> &events = run.input ? *run.input : NO_INPUT;
+        size_t nextEvent = 0;
+
+        RunConditions conditions = run.conditions;
+        while (true)
+        {
+            for (; nextEvent < events.size() && events[nextEvent].cycle <= chip8.getCycles(); ++nextEvent)
+            {
+                if (events[nextEvent].down) backend.press(events[nextEvent].key);
+                else backend.release(events[nextEvent].key);
+            }
+
+            //Stopping for an input event is only a pause
+            conditions.cycles = run.cycles;
+            if (nextEvent < events.size()) conditions.cycles = std::min(run.cycles, events[nextEvent].cycle);
+
+            result.stop = chip8.runUntil(conditions);
+            if (result.stop != StopReason::Cycles || chip8.getCycles() >= run.cycles) break;
+        }
+
+        result.cycles = chip8.getCycles();
+        result.ok = true;
+    } catch (const std::exception &e)
+    {
+        result.error = e.what();
+    }
+
+    result.frames = backend.getFrameCount();
+    result.framebufferHash = hashFramebuffer(backend.getFramebuffer());
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <manifest> [threads]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::vector<Run> runs = readManifest(argv[1]);
+
+        size_t numThreads = argc == 3 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+        numThreads = std::clamp<size_t>(numThreads, 1, std::max<size_t>(runs.size(), 1));
+
+        //Compiled sections are shared through the JITCache, so after the first few runs of a ROM there's little
+        //left to compile. A quarter of the threads keeps up with that.
+        CompilePool pool(std::max<size_t>(numThreads / 4, 1));
+
+        std::vector<RunResult> results(runs.size());
+        WorkStealingQueue queue(runs.size(), numThreads);
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t thread = 0; thread < numThreads; ++thread)
+        {
+            threads.emplace_back([&, thread] {
+                while (auto run = queue.next(thread))
+                {
+                    results[*run] = execute(runs[*run], *run, pool);
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t totalCycles = 0;
+        size_t failed = 0;
+
+        std::cout << "run\tstatus\tstop\tcycles\tframes\tframebuffer\tms\trom\tinput\terror" << std::endl;
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            const RunResult &result = results[i];
+            totalCycles += result.cycles;
+            if (!result.ok) failed++;
+
+            std::cout << i << "\t" << (result.ok ? "ok" : "error") << "\t";
+            if (result.stop) std::cout << *result.stop;
+            else std::cout << "-";
+            std::cout << "\t" << result.cycles << "\t" << result.frames
+                      << "\t" << std::hex << std::setw(16) << std::setfill('0') << result.framebufferHash << std::dec
+                      << "\t" << std::fixed << std::setprecision(3) << result.milliseconds << "\t" << runs[i].romPath
+                      << "\t" << (runs[i].inputPath.empty() ? "-" : runs[i].inputPath) << "\t" << result.error
+                      << std::endl;
+        }
+
+        std::cerr << runs.size() << " runs (" << failed << " failed) on " << numThreads << " threads in " << seconds
+                  << "s, " << static_cast<uint64_t>(totalCycles / seconds) << " cycles/s" << std::endl;
+
+        return failed == 0 ? 0 : 2;
+    } catch (const std::exception &e)
+    {
+        std::cerr << "Runtime error: " << e.what() << std::endl;
+        return 1;
+    }
+}
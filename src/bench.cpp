@@ -0,0 +1,361 @@
+#include "CHIP8.h"
+#include "BinaryFile.h"
+#include "MemoryBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#ifndef CHIP8_ROMS_DIR
+#define CHIP8_ROMS_DIR "roms"
+#endif
+
+//Benchmark: runs every ROM of a directory, and a few synthetic kernels, unthrottled for a fixed number of cycles
+//under each JIT mode, and prints a line per workload and mode. Instructions per second is the number to compare: a
+//cycle that calls into a compiled section runs the whole section, so cycles don't mean the same work across modes.
+//
+//Idle loops are executed rather than skipped, and ROMs get a fixed pattern of key presses so they don't just sit
+//waiting for input.
+//
+//With --coverage <dir>, every workload also runs once more, untimed and with exact coverage, to <dir>/<workload>.tsv
+//and .bitmap, to check what the workloads exercise.
+//
+//With --verify, every workload also runs once more, untimed and with every compiled section checked against the
+//interpreter, see JITVerifier. So do kernels covering every operand of the arithmetic instructions that set VF. The
+//first section that diverges ends the benchmark with its report.
+
+struct Workload
+{
+    std::string name;
+    std::vector<byte> rom;
+};
+
+struct Mode
+{
+    const char *name;
+    JITMode jit;
+    bool aot;
+};
+
+static const Mode MODES[] = {
+        {"interpreter", JITMode::Disabled, false},
+        //Everything compiled up front and on the spot, so as much as possible runs compiled from the first cycle
+        {"jit",         JITMode::Sync,     true},
+        //The default: hot functions are compiled in the background while the interpreter carries on
+        {"mixed",       JITMode::Async,    false},
+};
+
+struct Result
+{
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    double seconds = 0;
+    JITStats jit = {};
+    uint64_t residentBytes = 0;
+};
+
+//Cycles between changes of the pressed key
+constexpr uint64_t KEY_PERIOD = 2000;
+
+static std::vector<byte> assemble(const std::vector<opcode> &code)
+{
+    std::vector<byte> rom;
+    for (opcode op : code)
+    {
+        rom.push_back(op >> 8u);
+        rom.push_back(op & 0xffu);
+    }
+
+    return rom;
+}
+
+//The main loop calls a subroutine forever, which is where the JIT gets its chance
+static std::vector<Workload> syntheticKernels()
+{
+    return {
+            //Register arithmetic in a 256 iteration loop
+            {"<arith>", assemble({
+                    0x2204,         //0x200: call 0x204
+                    0x1200,         //       jp 0x200
+                    0x6000,         //0x204: ld V0, 0
+                    0x8104,         //0x206: add V1, V0
+                    0x8213,         //       xor V2, V1
+                    0x8325,         //       sub V3, V2
+                    0x7001,         //       add V0, 1
+                    0x3000,         //       se V0, 0
+                    0x1206,         //       jp 0x206
+                    0x00ee,         //       ret
+            })},
+            //A sprite per call, drawing isn't compiled
+            {"<draw>", assemble({
+                    0x2204,         //0x200: call 0x204
+                    0x1200,         //       jp 0x200
+                    0xa000,         //0x204: ld I, 0
+                    0xd015,         //       drw V0, V1, 5
+                    0x7003,         //       add V0, 3
+                    0x7101,         //       add V1, 1
+                    0x00ee,         //       ret
+            })},
+            //Many short subroutines, so calls and returns dominate
+            {"<call>", assemble({
+                    0x220a,         //0x200: call 0x20a
+                    0x2210,         //       call 0x210
+                    0x2216,         //       call 0x216
+                    0x221c,         //       call 0x21c
+                    0x1200,         //       jp 0x200
+                    0x7001,         //0x20a: add V0, 1
+                    0x8104,         //       add V1, V0
+                    0x00ee,         //       ret
+                    0x8213,         //0x210: xor V2, V1
+                    0x7203,         //       add V2, 3
+                    0x00ee,         //       ret
+                    0x8320,         //0x216: ld V3, V2
+                    0x8316,         //       shr V3
+                    0x00ee,         //       ret
+                    0x8434,         //0x21c: add V4, V3
+                    0x840e,         //       shl V4
+                    0x00ee,         //       ret
+            })},
+            //The subroutine rewrites its own first instruction every call, so its section is always stale
+            {"<selfmod>", assemble({
+                    0x2204,         //0x200: call 0x204
+                    0x1200,         //       jp 0x200
+                    0x7101,         //0x204: add V1, <V0 of the last call>
+                    0x7001,         //       add V0, 1
+                    0xa205,         //       ld I, 0x205
+                    0xf055,         //       ld [I], V0
+                    0x8214,         //       add V2, V1
+                    0x00ee,         //       ret
+            })},
+    };
+}
+
+//Only run with --verify: every x and y of each arithmetic instruction that sets VF, VF included on either side,
+//over registers refilled with random values every call
+static std::vector<Workload> flagKernels()
+{
+    std::vector<Workload> kernels;
+    for (opcode op : {0x8004, 0x8005, 0x8006, 0x8007, 0x800e})
+    {
+        std::vector<opcode> code = {
+                0x2204,             //0x200: call 0x204
+                0x1200,             //       jp 0x200
+        };
+        for (opcode x = 0; x < 16; ++x)
+        {
+            code.push_back(0xc0ff | (x << 8u));                 //rnd Vx, 0xff
+        }
+        for (opcode x = 0; x < 16; ++x)
+        {
+            for (opcode y = 0; y < 16; ++y)
+            {
+                code.push_back(op | (x << 8u) | (y << 4u));
+            }
+        }
+        code.push_back(0x00ee);                                 //ret
+
+        std::ostringstream name;
+        name << "<8xy" << std::hex << (op & 0xfu) << ">";
+        kernels.push_back(Workload{name.str(), assemble(code)});
+    }
+
+    return kernels;
+}
+
+static std::vector<Workload> readROMs(const std::string &dir)
+{
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(dir))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".ch8") paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Workload> roms;
+    for (const auto &path : paths)
+    {
+        roms.push_back(Workload{path.filename().string(), readBinaryFile(path.string().c_str())});
+    }
+
+    return roms;
+}
+
+static uint64_t residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    statm >> size >> resident;
+
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static CHIP8Options benchOptions(const Mode &mode)
+{
+    CHIP8Options options;
+    options.jit = mode.jit;
+    options.aot = mode.aot;
+    options.skipIdle = false;
+    options.seed = 0;
+
+    return options;
+}
+
+static void runWorkload(CHIP8 &chip8, MemoryBackend &backend, uint64_t cycles)
+{
+    for (uint64_t period = 0; chip8.getCycles() < cycles && !chip8.getIO().getExitFlag(); ++period)
+    {
+        backend.setKeys(1u << (period * 5 % KEYPAD_SIZE));
+        chip8.runFor(std::min(KEY_PERIOD, cycles - chip8.getCycles()));
+    }
+}
+
+static Result measure(const Workload &workload, const Mode &mode, uint64_t cycles)
+{
+    MemoryBackend backend;
+
+    //Ahead of time compilation is counted in the JIT stats, not in the run time
+    CHIP8 chip8(workload.rom, backend, benchOptions(mode));
+
+    auto start = std::chrono::steady_clock::now();
+
+    runWorkload(chip8, backend, cycles);
+
+    Result result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cycles = chip8.getCycles();
+    result.instructions = chip8.getInstructions();
+    result.jit = chip8.getJITStats();
+    result.residentBytes = residentBytes();
+
+    return result;
+}
+
+static void writeCoverage(const Workload &workload, uint64_t cycles, const std::string &dir)
+{
+    MemoryBackend backend;
+
+    //Compiled as much as possible, so the sections' counters get exercised as well
+    CHIP8Options options = benchOptions(MODES[1]);
+    options.coverage = CoverageMode::Exact;
+
+    CHIP8 chip8(workload.rom, backend, options);
+    runWorkload(chip8, backend, cycles);
+
+    //Kernel names aren't file names
+    std::string name = workload.name;
+    std::erase_if(name, [](char c) { return c == '<' || c == '>'; });
+    chip8.getCoverage()->writeFiles((std::filesystem::path(dir) / name).string(), chip8.getMemory());
+}
+
+static void verify(const Workload &workload, uint64_t cycles)
+{
+    MemoryBackend backend;
+
+    CHIP8Options options = benchOptions(MODES[1]);
+    options.verifyJIT = true;
+
+    CHIP8 chip8(workload.rom, backend, options);
+    try
+    {
+        runWorkload(chip8, backend, cycles);
+    } catch (const JITDivergence &e)
+    {
+        throw std::runtime_error(workload.name + ": " + e.what());
+    }
+
+    std::cerr << workload.name << ": " << chip8.getJITVerifier()->getSectionsVerified() << " sections verified"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t cycles = 1000000;
+    unsigned int repeat = 3;
+    std::string romsDir = CHIP8_ROMS_DIR;
+    std::string coverageDir;
+    bool verifyJIT = false;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc)
+            {
+                cycles = std::stoull(argv[++i]);
+            } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            {
+                repeat = std::max(1ul, std::stoul(argv[++i]));
+            } else if (std::strcmp(argv[i], "--coverage") == 0 && i + 1 < argc)
+            {
+                coverageDir = argv[++i];
+            } else if (std::strcmp(argv[i], "--verify") == 0)
+            {
+                verifyJIT = true;
+            } else if (argv[i][0] != '-')
+            {
+                romsDir = argv[i];
+            } else
+            {
+                std::cerr << "Usage: " << argv[0] << " [--cycles n] [--repeat n] [--coverage dir] [--verify]"
+                                                     " [roms dir]" << std::endl;
+                return 1;
+            }
+        }
+
+        std::vector<Workload> workloads = syntheticKernels();
+        for (auto &rom : readROMs(romsDir))
+        {
+            workloads.push_back(std::move(rom));
+        }
+
+        std::cout << "workload\tmode\tcycles\tinstructions\tseconds\tMIPS\tsections\tcache hits\tcompile ms\tcode KiB"
+                     "\tresident KiB" << std::endl;
+
+        for (const Workload &workload : workloads)
+        {
+            for (const Mode &mode : MODES)
+            {
+                //The fastest of the repetitions, it's the one least disturbed by the rest of the system
+                Result best;
+                for (unsigned int i = 0; i < repeat; ++i)
+                {
+                    Result result = measure(workload, mode, cycles);
+                    if (i == 0 || result.seconds < best.seconds) best = result;
+                }
+
+                std::cout << workload.name << "\t" << mode.name << "\t" << best.cycles << "\t" << best.instructions
+                          << "\t" << std::fixed << std::setprecision(4) << best.seconds << "\t" << std::setprecision(2)
+                          << best.instructions / best.seconds / 1e6 << "\t" << best.jit.sectionsCompiled << "\t"
+                          << best.jit.cacheHits << "\t" << std::setprecision(3)
+                          << best.jit.compileNanoseconds / 1e6 << "\t" << std::setprecision(1)
+                          << best.jit.codeBytes / 1024.0 << "\t" << best.residentBytes / 1024 << std::endl;
+            }
+
+            if (!coverageDir.empty()) writeCoverage(workload, cycles, coverageDir);
+            if (verifyJIT) verify(workload, cycles);
+        }
+
+        if (verifyJIT)
+        {
+            for (const Workload &kernel : flagKernels())
+            {
+                verify(kernel, cycles);
+            }
+        }
+    } catch (const std::exception &e)
+    {
+        std::cerr << "Runtime error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,6 +4,9 @@
 constexpr auto FONT_START = 0x0;
 constexpr auto ROM_START = 0x200;
 
+//The stack grows up from right after the font
+constexpr auto STACK_START = 0x50;
+
 constexpr auto MEMORY_SIZE = 0x1000;
 constexpr auto MEMORY_MASK = 0xfff;
 
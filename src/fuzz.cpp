@@ -0,0 +1,107 @@
+#include "CHIP8.h"
+#include "Coverage.h"
+#include "MemoryBackend.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+//libFuzzer target: every input is a ROM. It's disassembled, then run with everything reachable compiled up front and
+//hot functions compiled on the spot, for a fixed number of cycles. Errors the machine reports by throwing, such as an
+//invalid opcode or an access outside memory, are an expected way for a ROM to end; crashes and sanitizer reports are
+//what this looks for. So are compiled sections that don't do what the interpreter does, every section is checked
+//against it, see JITVerifier.
+//
+//Besides the coverage of the emulator itself, libFuzzer is fed which guest addresses ran and which way their skips
+//went, so it keeps inputs that take the guest somewhere new even through code paths of the host it already saw.
+
+constexpr uint64_t FUZZ_CYCLES = 10000;
+
+//Instructions compiled sections may run before their loops hand back every iteration, so a ROM looping forever in one
+//still ends with the cycle budget instead of timing out
+constexpr uint64_t FUZZ_COMPILED_INSTRUCTIONS = 1000000;
+
+//Cycles between changes of the pressed key, so ROMs waiting for one carry on
+constexpr uint64_t FUZZ_KEY_PERIOD = 500;
+
+//Hits, skips taken and skips that fell through, per guest address. libFuzzer reads them after every input and only
+//cares about the rough magnitude of each, so saturating them is enough.
+__attribute__((section("__libfuzzer_extra_counters"))) static uint8_t guestCounters[3 * MEMORY_SIZE];
+
+static uint8_t saturate(uint64_t count)
+{
+    return static_cast<uint8_t>(std::min<uint64_t>(count, UINT8_MAX));
+}
+
+static void reportCoverage(const Coverage &coverage)
+{
+    for (word addr = 0; addr < MEMORY_SIZE; ++addr)
+    {
+        uint64_t hits = coverage.getHits(addr);
+        uint64_t fallThroughs = std::min(coverage.getFallThroughs(addr), hits);
+
+        guestCounters[addr] = saturate(hits);
+        guestCounters[MEMORY_SIZE + addr] = saturate(hits - fallThroughs);
+        guestCounters[2 * MEMORY_SIZE + addr] = saturate(fallThroughs);
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > MEMORY_SIZE - ROM_START) return 0;
+
+    std::vector<byte> rom(data, data + size);
+
+    //Every printer, whether or not it's reachable
+    std::ostringstream disassembly;
+    for (size_t offset = 0; offset + 1 < rom.size(); offset += sizeof(opcode))
+    {
+        disassembly << parseInstruction((rom[offset] << 8u) | rom[offset + 1]) << "\n";
+    }
+
+    MemoryBackend backend;
+
+    CHIP8Options options;
+    options.jit = JITMode::Sync;
+    options.aot = true;
+    options.coverage = CoverageMode::Exact;
+    options.verifyJIT = true;
+    options.compiledInstructionLimit = FUZZ_COMPILED_INSTRUCTIONS;
+    options.seed = 0;
+
+    std::unique_ptr<CHIP8> chip8;
+    try
+    {
+        chip8 = std::make_unique<CHIP8>(rom, backend, options);
+    } catch (const std::exception &)
+    {
+        return 0;
+    }
+
+    try
+    {
+        for (uint64_t period = 0; chip8->getCycles() < FUZZ_CYCLES && !chip8->getIO().getExitFlag(); ++period)
+        {
+            backend.setKeys(1u << (period % KEYPAD_SIZE));
+            chip8->runFor(std::min(FUZZ_KEY_PERIOD, FUZZ_CYCLES - chip8->getCycles()));
+        }
+    } catch (const JITDivergence &e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::abort();
+    } catch (const std::exception &)
+    {
+        //The guest's own error, it covered what it did up to it all the same
+    }
+
+    reportCoverage(*chip8->getCoverage());
+
+    return 0;
+}
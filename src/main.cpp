@@ -1,8 +1,11 @@
 #include "types.h"
 #include "CHIP8.h"
+#include "BinaryFile.h"
+#include "SDLBackend.h"
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <vector>
 #include <stdexcept>
 #include <string>
@@ -11,30 +14,16 @@
 #include <unistd.h>
 #include <signal.h>
 
-std::vector<byte> readBinaryFile(const char *filename)
+//Nothing to show and nothing to read, but the review can still go by ear
+class BeepBackend final : public IOBackend
 {
-    std::ifstream file(filename, std::ios::binary);
+public:
+    void present(const std::array<bool, NUM_PIXELS> &bitmap) override
+    {}
 
-    if (!file.is_open())
-    {
-        throw std::runtime_error(std::string("Failed to open ") + filename);
-    }
-
-    file.unsetf(std::ios::skipws);
-
-    std::streampos bufSize;
-
-    file.seekg(0, std::ios::end);
-    bufSize = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    // reserve capacity
-    std::vector<byte> vec(bufSize);
-
-    file.read(reinterpret_cast<char *>(vec.data()), vec.size());
-
-    return vec;
-}
+    void pollEvents(std::array<bool, KEYPAD_SIZE> &keys, bool &exitFlag) override
+    {}
+};
 
 int hexLookup(unsigned char hex_digit)
 {
@@ -115,7 +104,18 @@ int main(int argc, char **argv)
         return 0;
     }
 
-    CHIP8 chip8(decoded);
+    std::unique_ptr<IOBackend> backend;
+    try
+    {
+        backend = std::make_unique<SDLBackend>("CHIP-8");
+    } catch (const std::runtime_error &e)
+    {
+        //the server would never be able to init and use SDL properly
+        std::cout << "[!] Could not initialize SDL, Pwn Lion can review based on beeps alone anyway" << std::endl;
+        backend = std::make_unique<BeepBackend>();
+    }
+
+    CHIP8 chip8(decoded, *backend);
 
     chip8.run();
 
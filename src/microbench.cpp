@@ -0,0 +1,203 @@
+#include "CHIP8.h"
+#include "Cpu.h"
+#include "DecodeTable.h"
+#include "IO.h"
+#include "JITSection.h"
+#include "Memory.h"
+#include "NullBackend.h"
+#include "Parser.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//Microbenchmark: measures every instruction on its own, with operands drawn at random from all the opcodes that
+//decode to it. For each one it prints the interpreter's execute() latency, the time compile() takes to emit it, and
+//the size of what it emits. Opcodes that throw when executed, or that don't compile (jumps out of the section), are
+//left out of the respective numbers and counted. Compile times are taken one instruction at a time, so they include
+//reading the clock.
+
+//Where the sampled instructions are placed, both for executing and for compiling
+constexpr word BENCH_ADDR = ROM_START;
+
+struct OpResult
+{
+    size_t executed = 0;
+    size_t threw = 0;
+    double executeNanoseconds = 0;
+
+    size_t compiled = 0;
+    size_t notCompiled = 0;
+    double compileNanoseconds = 0;
+    size_t codeBytes = 0;
+};
+
+static double nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Every execution starts from the same state: random registers and an I and sp that point into memory
+static Cpu randomCpu(std::mt19937 &rng)
+{
+    Cpu cpu(rng());
+    CHIP8::resetCpu(cpu);
+
+    for (reg &r : cpu.registers)
+    {
+        r = rng();
+    }
+    cpu.indexRegister = 0x300 + rng() % 0x100;
+    cpu.delayTimer = rng();
+    cpu.soundTimer = rng();
+    cpu.pc = BENCH_ADDR + sizeof(opcode);
+
+    return cpu;
+}
+
+static void measureExecute(const std::vector<opcode> &samples, size_t iterations, std::mt19937 &rng, OpResult &result)
+{
+    Memory memory;
+    NullBackend backend;
+    IO io(backend);
+
+    for (opcode op : samples)
+    {
+        const Instruction &insn = parseInstruction(op);
+        const Cpu initial = randomCpu(rng);
+        Cpu cpu = initial;
+
+        //Some operands are invalid for any state, like a ld [I] past the end of memory
+        try
+        {
+            insn.execute(cpu, memory, io);
+        } catch (const std::exception &)
+        {
+            result.threw++;
+            continue;
+        }
+
+        //Resetting the registers is part of the measurement, it costs the same for every instruction
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            cpu = initial;
+            insn.execute(cpu, memory, io);
+        }
+        result.executeNanoseconds += nanosecondsSince(start);
+        result.executed += iterations;
+    }
+}
+
+static void measureCompile(const std::vector<opcode> &samples, OpResult &result)
+{
+    //All samples go in one section, one after the other, so skips over them have somewhere to land
+    asmjit::CodeHolder code;
+    code.init(JITCache::instance().environment());
+    JITSection jit(BENCH_ADDR, samples.size(), &code);
+
+    word pc = BENCH_ADDR;
+    for (opcode op : samples)
+    {
+        const Instruction &insn = parseInstruction(op);
+        pc += sizeof(opcode);
+
+        size_t before = jit.assm.offset();
+        auto start = std::chrono::steady_clock::now();
+
+        bool compiled;
+        try
+        {
+            compiled = insn.compile(jit, pc);
+        } catch (const std::exception &)
+        {
+            compiled = false;
+        }
+
+        double nanoseconds = nanosecondsSince(start);
+
+        if (!compiled)
+        {
+            result.notCompiled++;
+            continue;
+        }
+
+        result.compiled++;
+        result.compileNanoseconds += nanoseconds;
+        result.codeBytes += jit.assm.offset() - before;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t numSamples = 256;
+    size_t iterations = 1000;
+    uint32_t seed = 0;
+
+    try
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            if (std::strcmp(argv[i], "--samples") == 0) numSamples = std::stoul(argv[i + 1]);
+            else if (std::strcmp(argv[i], "--iterations") == 0) iterations = std::stoul(argv[i + 1]);
+            else if (std::strcmp(argv[i], "--seed") == 0) seed = std::stoul(argv[i + 1]);
+            else argc = -1;
+        }
+
+        if (argc < 1 || argc % 2 == 0 || numSamples == 0)
+        {
+            std::cerr << "Usage: " << argv[0] << " [--samples n] [--iterations n] [--seed n]" << std::endl;
+            return 1;
+        }
+
+        //Every opcode, by what it decodes to
+        std::vector<std::vector<opcode>> opcodes(NUM_OPS);
+        for (unsigned int op = 0; op < DECODE_TABLE_SIZE; ++op)
+        {
+            opcodes[static_cast<size_t>(decode(op).op)].push_back(op);
+        }
+
+        std::mt19937 rng(seed);
+
+        std::cout << "op\topcodes\texecute ns\tthrew\tcompile ns\tcode bytes\tnot compiled" << std::endl;
+
+        for (size_t op = 0; op < NUM_OPS; ++op)
+        {
+            std::vector<opcode> samples;
+            std::uniform_int_distribution<size_t> pick(0, opcodes[op].size() - 1);
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                samples.push_back(opcodes[op][pick(rng)]);
+            }
+
+            OpResult result;
+            measureExecute(samples, iterations, rng, result);
+            measureCompile(samples, result);
+
+            std::cout << opName(static_cast<Op>(op)) << "\t" << opcodes[op].size() << "\t" << std::fixed << std::setprecision(2);
+            if (result.executed != 0) std::cout << result.executeNanoseconds / result.executed;
+            else std::cout << "-";
+            std::cout << "\t" << result.threw << "\t";
+            if (result.compiled != 0)
+            {
+                std::cout << result.compileNanoseconds / result.compiled << "\t" << std::setprecision(1)
+                          << static_cast<double>(result.codeBytes) / result.compiled;
+            } else
+            {
+                std::cout << "-\t-";
+            }
+            std::cout << "\t" << result.notCompiled << std::endl;
+        }
+    } catch (const std::exception &e)
+    {
+        std::cerr << "Runtime error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "CHIP8.h"
+#include "BinaryFile.h"
+#include "GuestProfiler.h"
+#include "InputLog.h"
+#include "RecordingBackend.h"
+#include "SDLBackend.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+//Plays a ROM in a window, optionally recording the session for chip8_replay
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <rom.ch8> [--record <log>] [--seed <n>] [--profile <prefix>]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::vector<byte> rom = readBinaryFile(argv[1]);
+
+        const char *recordPath = nullptr;
+        const char *profilePath = nullptr;
+        CHIP8Options options;
+        options.seed = std::random_device{}();
+
+        for (int i = 2; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+            else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) options.seed = std::stoul(argv[++i]);
+            else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profilePath = argv[++i];
+            else throw std::runtime_error(std::string("Unknown argument ") + argv[i]);
+        }
+
+        SDLBackend sdl("CHIP-8");
+
+        std::unique_ptr<InputLogWriter> log;
+        std::unique_ptr<RecordingBackend> recorder;
+        IOBackend *backend = &sdl;
+
+        if (recordPath != nullptr)
+        {
+            //Background compilation would make the session depend on timing
+            options.jit = JITMode::Sync;
+
+            log = std::make_unique<InputLogWriter>(recordPath, options.jit, options.seed.value(),
+                                                   InputLog::hashROM(rom));
+            recorder = std::make_unique<RecordingBackend>(sdl, *log);
+            backend = recorder.get();
+        }
+
+        CHIP8 chip8(rom, *backend, options);
+
+        std::optional<GuestProfiler> profiler;
+        if (profilePath != nullptr)
+        {
+            profiler.emplace();
+            profiler->attach(chip8);
+        }
+
+        chip8.run();
+        chip8.getRunLoopStats()->print(std::cerr);
+
+        if (profiler)
+        {
+            profiler->detach();
+            profiler->writeFiles(profilePath);
+        }
+    } catch (const std::runtime_error &rt)
+    {
+        std::cout << "Runtime error: " << rt.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
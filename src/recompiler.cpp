@@ -0,0 +1,100 @@
+#include "CHIP8.h"
+#include "ControlFlow.h"
+#include "BinaryFile.h"
+#include "JIT.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//Static recompiler: compiles every subroutine of a ROM that static analysis can find, and writes a source file
+//defining STATIC_ROM (see StaticROM.h) with the ROM and the flattened code of every section. Linking it against
+//static_main.cpp gives an executable that never compiles anything for the code it was built from, and the JIT and
+//interpreter still handle whatever can't be known statically (indirect jumps, self-modifying code).
+
+static void writeBytes(std::ostream &out, const std::vector<byte> &bytes)
+{
+    out << "{";
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        if (i % 16 == 0) out << "\n                ";
+        out << "0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(bytes[i]) << ", ";
+    }
+    out << std::dec << "\n        }";
+}
+
+static void check(asmjit::Error err)
+{
+    if (err) throw std::runtime_error("asmjit::Error : " + std::to_string(err));
+}
+
+static std::vector<byte> flatten(asmjit::CodeHolder &code)
+{
+    //Sections only use relative jumps, so the base doesn't matter. Code that failed to link mustn't end up in the
+    //output, it would run as is.
+    check(code.flatten());
+    check(code.resolveUnresolvedLinks());
+    check(code.relocateToBase(0));
+
+    std::vector<byte> bytes(code.codeSize());
+    check(code.copyFlattenedData(bytes.data(), bytes.size()));
+    return bytes;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <rom.ch8> <output.cpp>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::vector<byte> rom = readBinaryFile(argv[1]);
+
+        Memory memory;
+        CHIP8::loadROM(memory, rom);
+
+        std::ofstream out(argv[2], std::ios::trunc);
+        if (!out.is_open()) throw std::runtime_error(std::string("Failed to open ") + argv[2]);
+
+        out << "//Generated by chip8_recompiler from " << argv[1] << ", do not edit.\n\n"
+            << "#include \"StaticROM.h\"\n\n"
+            << "const StaticROM STATIC_ROM = {\n"
+            << "        ";
+        writeBytes(out, rom);
+        out << ",\n        {\n";
+
+        size_t numSections = 0;
+        for (word addr : findSubroutines(memory, ROM_START))
+        {
+            std::vector<byte> guest = JIT::readFunction(memory, addr);
+
+            asmjit::CodeHolder code;
+            code.init(JITCache::instance().environment());
+            word numCompiled = JIT::emit(code, addr, guest);
+            if (numCompiled < JIT::MIN_SECTION_INSNS) continue;
+
+            out << "        {0x" << std::hex << addr << std::dec << ", ";
+            writeBytes(out, guest);
+            out << ", ";
+            writeBytes(out, flatten(code));
+            out << ", " << numCompiled << "},\n";
+            numSections++;
+        }
+
+        out << "        }\n};\n";
+
+        std::cout << "Recompiled " << numSections << " sections from " << argv[1] << std::endl;
+    } catch (const std::runtime_error &rt)
+    {
+        std::cerr << "Runtime error: " << rt.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "CHIP8.h"
+#include "BinaryFile.h"
+#include "GuestProfiler.h"
+#include "InputLog.h"
+#include "ReplayBackend.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+//Replays a session recorded by chip8_play as fast as possible, and prints where it ended up. With --expect, exits
+//with 2 if the final frame doesn't hash to the given value, for regression tests. With --profile, writes a profile of
+//the guest, see GuestProfiler. With --coverage, writes what executed, see Coverage.
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <rom.ch8> <log> [--expect <framebuffer hash>] [--profile <prefix>]"
+                     " [--coverage <prefix>]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::optional<uint64_t> expected;
+        const char *profilePath = nullptr;
+        const char *coveragePath = nullptr;
+
+        for (int i = 3; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--expect") == 0 && i + 1 < argc) expected = std::stoull(argv[++i], nullptr, 16);
+            else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profilePath = argv[++i];
+            else if (std::strcmp(argv[i], "--coverage") == 0 && i + 1 < argc) coveragePath = argv[++i];
+            else throw std::runtime_error(std::string("Unknown argument ") + argv[i]);
+        }
+
+        std::vector<byte> rom = readBinaryFile(argv[1]);
+        InputLog log = readInputLog(argv[2]);
+
+        if (log.romHash != InputLog::hashROM(rom))
+        {
+            throw std::runtime_error(std::string(argv[2]) + " was recorded with a different ROM");
+        }
+
+        ReplayBackend backend(log);
+
+        CHIP8Options options;
+        options.jit = log.jitMode;
+        options.seed = log.seed;
+        if (coveragePath != nullptr) options.coverage = CoverageMode::Exact;
+
+        CHIP8 chip8(rom, backend, options);
+
+        std::optional<GuestProfiler> profiler;
+        if (profilePath != nullptr)
+        {
+            profiler.emplace();
+            profiler->attach(chip8);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        while (!chip8.getIO().getExitFlag())
+        {
+            chip8.runFor(CLOCK_HZ);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (profiler)
+        {
+            profiler->detach();
+            profiler->writeFiles(profilePath);
+        }
+
+        if (coveragePath != nullptr) chip8.getCoverage()->writeFiles(coveragePath, chip8.getMemory());
+
+        uint64_t hash = hashFramebuffer(backend.getFramebuffer());
+
+        std::cout << "cycles: " << chip8.getCycles() << "\n"
+                  << "session: " << static_cast<double>(chip8.getCycles()) / CLOCK_HZ << "s, replayed in " << seconds
+                  << "s (" << chip8.getCycles() / (seconds * CLOCK_HZ) << "x realtime)\n"
+                  << "framebuffer: " << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec
+                  << std::endl;
+
+        if (expected && hash != *expected) return 2;
+    } catch (const std::runtime_error &rt)
+    {
+        std::cout << "Runtime error: " << rt.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include "CHIP8.h"
+#include "JITCache.h"
+#include "StaticROM.h"
+#include "SDLBackend.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+//Entry point of the executables built by chip8_add_static_rom. STATIC_ROM comes from the source the recompiler
+//generated for the ROM.
+int main()
+{
+    for (const auto &section : STATIC_ROM.sections)
+    {
+        JITCache::instance().preload(section.addr, section.guest, section.code, section.numCompiled);
+    }
+
+    std::unique_ptr<IOBackend> backend;
+    try
+    {
+        backend = std::make_unique<SDLBackend>("CHIP-8");
+    } catch (const std::runtime_error &e)
+    {
+        std::cout << "[!] Could not initialize SDL, running without a display" << std::endl;
+        backend = std::make_unique<NullBackend>();
+    }
+
+    try
+    {
+        //AOT finds the preloaded sections in the cache, so nothing is compiled and nothing has to warm up
+        CHIP8Options options;
+        options.aot = true;
+
+        CHIP8 chip8(STATIC_ROM.rom, *backend, options);
+        chip8.run();
+        chip8.getRunLoopStats()->print(std::cerr);
+    } catch (const std::runtime_error &rt)
+    {
+        std::cout << "Runtime error: " << rt.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
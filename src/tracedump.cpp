@@ -0,0 +1,55 @@
+#include "Parser.h"
+#include "TraceRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+//Prints a trace written by CHIP8::step(): the instructions leading up to the error, oldest first, and the machine as
+//it was when it stopped
+int main(int argc, char **argv)
+{
+    if (argc != 2 && !(argc == 4 && std::strcmp(argv[2], "--last") == 0))
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace.bin> [--last <n>]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        Trace trace = readTrace(argv[1]);
+
+        size_t first = 0;
+        if (argc == 4) first = trace.entries.size() - std::min<size_t>(std::stoul(argv[3]), trace.entries.size());
+
+        std::cout << "cycle\tpc\topcode\tI\tsp\tinstruction\n";
+        for (size_t i = first; i < trace.entries.size(); ++i)
+        {
+            const TraceEntry &entry = trace.entries[i];
+            std::cout << std::dec << entry.cycle << std::hex << std::setfill('0')
+                      << "\t0x" << std::setw(3) << entry.pc << "\t" << std::setw(4) << entry.opcode
+                      << "\t0x" << std::setw(3) << entry.indexRegister << "\t0x" << std::setw(3) << entry.sp
+                      << "\t" << parseInstruction(entry.opcode) << "\n";
+        }
+
+        std::cout << std::hex << std::setfill('0') << "\nstopped at cycle " << std::dec << trace.cycles << std::hex
+                  << ", pc 0x" << std::setw(3) << trace.pc << ": " << trace.message << "\n"
+                  << "I 0x" << std::setw(3) << trace.indexRegister << "  sp 0x" << std::setw(3) << trace.sp
+                  << "  dt " << std::setw(2) << +trace.delayTimer << "  st " << std::setw(2) << +trace.soundTimer
+                  << "\n";
+        for (size_t i = 0; i < std::size(trace.registers); ++i)
+        {
+            std::cout << "V" << std::uppercase << i << std::nouppercase << " " << std::setw(2) << +trace.registers[i]
+                      << (i % 8 == 7 ? "\n" : "  ");
+        }
+    } catch (const std::exception &e)
+    {
+        std::cerr << "Runtime error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -15,10 +15,19 @@ using opcode = word;
 
 constexpr size_t MAX_REG = 0xff;
 
-byte getNibble(word in, word nibbleShift = 0);
-
-byte getByte(word in, word nibbleShift = 0);
-
-addr12 getAddress(word in, word nibbleShift = 0);
+constexpr byte getNibble(word in, word nibbleShift = 0)
+{
+    return (in >> (4u * nibbleShift)) & 0xf;
+}
+
+constexpr byte getByte(word in, word nibbleShift = 0)
+{
+    return (in >> (4u * nibbleShift)) & 0xff;
+}
+
+constexpr addr12 getAddress(word in, word nibbleShift = 0)
+{
+    return (in >> (4u * nibbleShift)) & 0xfff;
+}
 
 std::ostream &operator<<(std::ostream &stream, imm8 byte);
\ No newline at end of file